@@ -0,0 +1,54 @@
+#include "bitrate.hpp"
+#include <algorithm>
+
+constexpr double DECREASE_FACTOR = 0.85;
+constexpr double INCREASE_FACTOR = 0.05;
+constexpr double MIN_INCREASE = 100.;
+constexpr auto DECREASE_INTERVAL = std::chrono::seconds(1);
+constexpr double MAX_LATE_FRAME_RATIO = 0.05; // A frame dropped now and then is the sink's doing, not the network's
+constexpr double MAX_DELAY_STEP = 1000.;      // In milliseconds, beyond which the stream was restarted rather than queued
+
+BitrateController::BitrateController(unsigned int bitrate, unsigned int min_bitrate, unsigned int max_bitrate):
+    min_bitrate(std::min(min_bitrate, max_bitrate)),
+    max_bitrate(std::max(min_bitrate, max_bitrate)) {
+    reset(bitrate);
+}
+
+void BitrateController::reset(unsigned int bitrate) {
+    this->bitrate = std::clamp(bitrate, min_bitrate, max_bitrate);
+    last_one_way_delay = NAN;
+    delay_gradient = 0.;
+}
+
+unsigned int BitrateController::update(const BitrateSample& sample) {
+    // Queues building up along the path make each interval's frames arrive later relative to when they were sent
+    if (!isnan(sample.one_way_delay)) {
+        if (!isnan(last_one_way_delay) && fabs(sample.one_way_delay - last_one_way_delay) < MAX_DELAY_STEP) {
+            delay_gradient = delay_gradient * 0.8 + (sample.one_way_delay - last_one_way_delay) * 0.2;
+        }
+        last_one_way_delay = sample.one_way_delay;
+    }
+
+    bool overuse = sample.loss_rate > 0.05 ||
+                   sample.late_frames > std::max(sample.frames * MAX_LATE_FRAME_RATIO, 1.) ||
+                   sample.jitter > 30. ||
+                   delay_gradient > 2.;
+    bool underuse = sample.loss_rate < 0.02 &&
+                    sample.jitter < 15. &&
+                    delay_gradient < 0.5;
+
+    auto now = std::chrono::steady_clock::now();
+    if (overuse) {
+        // Give the previous decrease time to take effect before backing off again
+        if (now - last_decrease >= DECREASE_INTERVAL) {
+            double base = sample.measured_bitrate > 0. ? std::min(bitrate, sample.measured_bitrate) : bitrate;
+            bitrate = base * DECREASE_FACTOR;
+            last_decrease = now;
+        }
+    } else if (underuse) {
+        bitrate += std::max(bitrate * INCREASE_FACTOR, MIN_INCREASE);
+    }
+
+    bitrate = std::clamp(bitrate, (double) min_bitrate, (double) max_bitrate);
+    return bitrate;
+}
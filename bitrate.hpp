@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <math.h>
+#include <stdint.h>
+
+// What the receiver observed since the previous update
+struct BitrateSample {
+    double loss_rate = 0.;        // Fraction of packets lost
+    double jitter = 0.;           // In milliseconds
+    uint64_t late_frames = 0;     // Frames dropped by the sink for being late
+    double frames = 0.;           // Frames received
+    double one_way_delay = NAN;   // Mean over the frames received, in milliseconds with an arbitrary offset, NaN if there were none
+    double measured_bitrate = 0.; // In kbps
+};
+
+// Receiver-side rate controller combining AIMD with a delay-gradient overuse detector
+// All bitrates are in kbps
+class BitrateController {
+protected:
+    unsigned int min_bitrate;
+    unsigned int max_bitrate;
+    double bitrate;
+
+    double last_one_way_delay = NAN;
+    double delay_gradient = 0.;
+    std::chrono::steady_clock::time_point last_decrease;
+
+public:
+    BitrateController(unsigned int bitrate, unsigned int min_bitrate, unsigned int max_bitrate);
+
+    unsigned int get_bitrate() const {
+        return bitrate;
+    }
+
+    // Used when the bitrate is changed by the user
+    void reset(unsigned int bitrate);
+
+    // Returns the new target bitrate
+    unsigned int update(const BitrateSample& sample);
+};
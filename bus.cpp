@@ -0,0 +1,120 @@
+#include "bus.hpp"
+#include "glib.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <string.h>
+#include <utility>
+
+static bool is_decoder(GstObject* object) {
+    if (!GST_IS_ELEMENT(object)) return false;
+    const char* klass = gst_element_get_metadata(GST_ELEMENT(object), GST_ELEMENT_METADATA_KLASS);
+    return klass && strstr(klass, "Decoder");
+}
+
+static bool is_sink(GstObject* object) {
+    return GST_IS_ELEMENT(object) && GST_OBJECT_FLAG_IS_SET(object, GST_ELEMENT_FLAG_SINK);
+}
+
+BusMonitor::BusMonitor(GstElement* pipeline, std::function<void()> on_decoder_error):
+    pipeline(pipeline),
+    bus(gst_element_get_bus(pipeline)),
+    on_decoder_error(std::move(on_decoder_error)) {
+    gst_bus_set_sync_handler(bus, [](GstBus* bus, GstMessage* message, void* data) {
+        ((BusMonitor*) data)->handle_message(message);
+
+        // Nothing else reads from the bus, so keeping the message would only leak it into the bus's queue
+        gst_message_unref(message);
+        return GST_BUS_DROP;
+    },
+        this,
+        nullptr);
+}
+
+BusMonitor::~BusMonitor() {
+    gst_bus_set_sync_handler(bus, nullptr, nullptr, nullptr);
+    gst_object_unref(bus);
+}
+
+void BusMonitor::handle_message(GstMessage* message) {
+    switch (GST_MESSAGE_TYPE(message)) {
+    case GST_MESSAGE_QOS: {
+        GstFormat format;
+        guint64 processed;
+        guint64 dropped;
+        gint64 jitter;
+        gst_message_parse_qos_stats(message, &format, &processed, &dropped);
+        gst_message_parse_qos_values(message, &jitter, nullptr, nullptr);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (is_sink(GST_MESSAGE_SRC(message))) {
+            stats.sink_late_frames++;
+            if (jitter > 0) {
+                stats.max_sink_lateness = std::max(stats.max_sink_lateness, jitter / (double) GST_MSECOND);
+            }
+            if (format == GST_FORMAT_BUFFERS || format == GST_FORMAT_DEFAULT) {
+                if (processed != (guint64) -1) stats.processed_frames = processed;
+                if (dropped != (guint64) -1) stats.dropped_frames = dropped;
+            }
+        } else if (is_decoder(GST_MESSAGE_SRC(message))) {
+            stats.decoder_drops++;
+        }
+        break;
+    }
+
+    case GST_MESSAGE_ERROR: {
+        GError* error;
+        gst_message_parse_error(message, &error, nullptr);
+
+        mutex.lock();
+        stats.errors++;
+        stats.last_error = std::string(GST_OBJECT_NAME(GST_MESSAGE_SRC(message))) + ": " + error->message;
+        mutex.unlock();
+        g_error_free(error);
+
+        if (on_decoder_error && is_decoder(GST_MESSAGE_SRC(message))) {
+            on_decoder_error();
+        }
+        break;
+    }
+
+    case GST_MESSAGE_WARNING: {
+        mutex.lock();
+        stats.warnings++;
+        mutex.unlock();
+
+        if (on_decoder_error && is_decoder(GST_MESSAGE_SRC(message))) {
+            on_decoder_error();
+        }
+        break;
+    }
+
+    case GST_MESSAGE_LATENCY: {
+        mutex.lock();
+        stats.latency_changes++;
+        mutex.unlock();
+
+        // Latency can't be recalculated from a streaming thread
+        awake([pipeline = glib::Object<GstElement>((GstElement*) gst_object_ref(pipeline))]() {
+            gst_bin_recalculate_latency(GST_BIN(pipeline.get()));
+        });
+        break;
+    }
+
+    case GST_MESSAGE_BUFFERING: {
+        int percent;
+        gst_message_parse_buffering(message, &percent);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.buffering_percent = percent;
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+BusStats BusMonitor::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <functional>
+#include <gst/gst.h>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+
+struct BusStats {
+    uint64_t decoder_drops = 0;    // Frames dropped by decoders according to their QoS messages
+    uint64_t sink_late_frames = 0; // QoS messages from sinks, one per late or dropped frame
+    double max_sink_lateness = 0.; // In milliseconds
+    uint64_t processed_frames = 0; // As last reported by a sink
+    uint64_t dropped_frames = 0;   // As last reported by a sink
+    uint64_t errors = 0;
+    uint64_t warnings = 0;
+    std::string last_error;
+    uint64_t latency_changes = 0;
+    int buffering_percent = 100;
+};
+
+// Consumes the messages a pipeline posts on its bus as they are posted, from whichever thread posts them
+class BusMonitor {
+protected:
+    GstElement* pipeline;
+    GstBus* bus;
+    std::function<void()> on_decoder_error;
+
+    mutable std::mutex mutex;
+    BusStats stats;
+
+    void handle_message(GstMessage* message);
+
+public:
+    // The monitor must be destroyed only after the pipeline has been set to GST_STATE_NULL
+    // on_decoder_error is called from the posting thread whenever a decoder reports an error or a warning
+    BusMonitor(GstElement* pipeline, std::function<void()> on_decoder_error = {});
+    BusMonitor(const BusMonitor&) = delete;
+    BusMonitor(BusMonitor&&) = delete;
+
+    BusMonitor& operator=(const BusMonitor&) = delete;
+    BusMonitor& operator=(BusMonitor&&) = delete;
+
+    ~BusMonitor();
+
+    BusStats get_stats() const;
+};
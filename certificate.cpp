@@ -0,0 +1,120 @@
+#include "certificate.hpp"
+#include "util.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <openssl/bn.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+#include <system_error>
+
+constexpr std::chrono::hours CERTIFICATE_ROTATION_INTERVAL(24 * 30);
+constexpr long CERTIFICATE_VALIDITY = 60 * 60 * 24 * 365; // In seconds, long enough that rotation always comes first
+
+// Checks that both files can be read, that the certificate hasn't expired, and that it matches the key
+static bool is_usable(const DtlsCertificate& certificate) {
+    std::unique_ptr<BIO, decltype(&BIO_free)> cert_bio(BIO_new_file(certificate.certificate_path.c_str(), "r"), BIO_free);
+    std::unique_ptr<BIO, decltype(&BIO_free)> key_bio(BIO_new_file(certificate.key_path.c_str(), "r"), BIO_free);
+    if (!cert_bio || !key_bio) return false;
+
+    std::unique_ptr<X509, decltype(&X509_free)> cert(PEM_read_bio_X509(cert_bio.get(), nullptr, nullptr, nullptr), X509_free);
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(PEM_read_bio_PrivateKey(key_bio.get(), nullptr, nullptr, nullptr), EVP_PKEY_free);
+    return cert && key && X509_cmp_current_time(X509_get0_notAfter(cert.get())) > 0 && X509_check_private_key(cert.get(), key.get()) == 1;
+}
+
+// Writes to a temporary file that only the user can read, then moves it into place
+static bool write_pem(const std::filesystem::path& path, const std::function<int(BIO*)>& write) {
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    if (std::ofstream file(temp_path); !file.is_open()) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::permissions(temp_path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, ec);
+
+    std::unique_ptr<BIO, decltype(&BIO_free)> bio(BIO_new_file(temp_path.string().c_str(), "w"), BIO_free);
+    if (!bio || !write(bio.get())) {
+        return false;
+    }
+    bio.reset();
+
+    std::filesystem::rename(temp_path, path, ec);
+    return !ec;
+}
+
+static bool generate(const DtlsCertificate& certificate) {
+    // ECDSA with P-256 is what libdatachannel would otherwise generate, and is much cheaper than RSA
+    EVP_PKEY* raw_key = nullptr;
+    {
+        std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> key_ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), EVP_PKEY_CTX_free);
+        if (!key_ctx ||
+            EVP_PKEY_keygen_init(key_ctx.get()) <= 0 ||
+            EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_ctx.get(), NID_X9_62_prime256v1) <= 0 ||
+            EVP_PKEY_keygen(key_ctx.get(), &raw_key) <= 0) {
+            return false;
+        }
+    }
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(raw_key, EVP_PKEY_free);
+
+    std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), X509_free);
+    if (!cert) return false;
+    X509_set_version(cert.get(), 2);
+
+    unsigned char serial[16];
+    if (RAND_bytes(serial, sizeof serial) != 1) return false;
+    serial[0] &= 0x7F; // Serial numbers must be positive
+    std::unique_ptr<BIGNUM, decltype(&BN_free)> serial_bn(BN_bin2bn(serial, sizeof serial, nullptr), BN_free);
+    if (!serial_bn || !BN_to_ASN1_INTEGER(serial_bn.get(), X509_get_serialNumber(cert.get()))) return false;
+
+    // Backdated by a day in case the peer's clock is behind
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), -60 * 60 * 24);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), CERTIFICATE_VALIDITY);
+
+    X509_NAME* name = X509_get_subject_name(cert.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*) "lux-desktop", -1, -1, 0);
+    if (!X509_set_issuer_name(cert.get(), name) || !X509_set_pubkey(cert.get(), key.get()) || !X509_sign(cert.get(), key.get(), EVP_sha256())) {
+        return false;
+    }
+
+    // The key is written first, since a certificate that doesn't match its key is replaced anyway
+    return write_pem(certificate.key_path, [&key](BIO* bio) {
+        return PEM_write_bio_PrivateKey(bio, key.get(), nullptr, nullptr, 0, nullptr, nullptr);
+    }) &&
+           write_pem(certificate.certificate_path, [&cert](BIO* bio) {
+               return PEM_write_bio_X509(bio, cert.get());
+           });
+}
+
+std::optional<DtlsCertificate> get_dtls_certificate() {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::filesystem::path config_path = get_config_path();
+    if (config_path.empty()) return std::nullopt;
+    std::filesystem::path dtls_path = config_path / "dtls";
+    DtlsCertificate certificate = {
+        .certificate_path = (dtls_path / "certificate.pem").string(),
+        .key_path = (dtls_path / "key.pem").string(),
+    };
+
+    // The certificate's age is taken from its file, which is only written when a new one is generated
+    std::error_code ec;
+    auto last_write_time = std::filesystem::last_write_time(certificate.certificate_path, ec);
+    if (!ec && std::filesystem::file_time_type::clock::now() - last_write_time < CERTIFICATE_ROTATION_INTERVAL && is_usable(certificate)) {
+        return certificate;
+    }
+
+    std::filesystem::create_directories(dtls_path, ec);
+    if (!generate(certificate)) {
+        std::cerr << "Error: Failed to generate DTLS certificate" << std::endl;
+        return std::nullopt;
+    }
+    return certificate;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+struct DtlsCertificate {
+    std::string certificate_path;
+    std::string key_path;
+};
+
+// Returns the PEM files of a self-signed DTLS certificate kept in the configuration directory, generating it if there is none yet
+// Peer connections given these files skip generating a key pair of their own
+// The certificate is replaced once it is old enough for rotation, so that it can't identify the client for longer than that
+// Returns nullopt if the files can't be read or written, in which case connections should generate their own certificate
+std::optional<DtlsCertificate> get_dtls_certificate();
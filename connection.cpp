@@ -1,8 +1,51 @@
 #include "connection.hpp"
 #include "json.hpp"
+#include <algorithm>
 
 using nlohmann::json;
 
+NLOHMANN_JSON_SERIALIZE_ENUM(DecoderProfile,
+    {
+        {DecoderProfile::Auto, "auto"},
+        {DecoderProfile::LowLatency, "low_latency"},
+        {DecoderProfile::Throughput, "throughput"},
+    })
+
+NLOHMANN_JSON_SERIALIZE_ENUM(LatencyProfile,
+    {
+        {LatencyProfile::Competitive, "competitive"},
+        {LatencyProfile::Balanced, "balanced"},
+        {LatencyProfile::Smooth, "smooth"},
+    })
+
+NLOHMANN_JSON_SERIALIZE_ENUM(ErrorConcealment,
+    {
+        {ErrorConcealment::ShowCorrupt, "show_corrupt"},
+        {ErrorConcealment::FreezeOnLastGood, "freeze"},
+    })
+
+const char* video_codec_name(VideoCodec codec) {
+    switch (codec) {
+    case VideoCodec::H265:
+        return "h265";
+    case VideoCodec::AV1:
+        return "av1";
+    case VideoCodec::VP9:
+        return "vp9";
+    default:
+        return "h264";
+    }
+}
+
+std::optional<VideoCodec> parse_video_codec(const std::string& name) {
+    for (VideoCodec codec : {VideoCodec::H264, VideoCodec::H265, VideoCodec::AV1, VideoCodec::VP9}) {
+        if (name == video_codec_name(codec)) {
+            return codec;
+        }
+    }
+    return std::nullopt;
+}
+
 ConnectionInfo::ConnectionInfo(const json& conn_json) {
     if (auto address_it = conn_json.find("address"); address_it != conn_json.end() && address_it->is_string()) {
         address = *address_it;
@@ -22,9 +65,69 @@ ConnectionInfo::ConnectionInfo(const json& conn_json) {
     if (auto verify_certs_it = conn_json.find("verify_certs"); verify_certs_it != conn_json.end() && verify_certs_it->is_boolean()) {
         verify_certs = *verify_certs_it;
     }
+    if (auto trickle_ice_it = conn_json.find("trickle_ice"); trickle_ice_it != conn_json.end() && trickle_ice_it->is_boolean()) {
+        trickle_ice = *trickle_ice_it;
+    }
+    if (auto prepare_on_select_it = conn_json.find("prepare_on_select"); prepare_on_select_it != conn_json.end() && prepare_on_select_it->is_boolean()) {
+        prepare_on_select = *prepare_on_select_it;
+    }
+    if (auto adaptive_bitrate_it = conn_json.find("adaptive_bitrate"); adaptive_bitrate_it != conn_json.end() && adaptive_bitrate_it->is_boolean()) {
+        adaptive_bitrate = *adaptive_bitrate_it;
+    }
+    if (auto min_bitrate_it = conn_json.find("min_bitrate"); min_bitrate_it != conn_json.end() && min_bitrate_it->is_number_unsigned()) {
+        min_bitrate = *min_bitrate_it;
+    }
+    if (auto max_bitrate_it = conn_json.find("max_bitrate"); max_bitrate_it != conn_json.end() && max_bitrate_it->is_number_unsigned()) {
+        max_bitrate = *max_bitrate_it;
+    }
+    if (auto decoder_profile_it = conn_json.find("decoder_profile"); decoder_profile_it != conn_json.end() && decoder_profile_it->is_string()) {
+        decoder_profile = *decoder_profile_it;
+    }
+    if (auto decoder_threads_it = conn_json.find("decoder_threads"); decoder_threads_it != conn_json.end() && decoder_threads_it->is_number_unsigned()) {
+        decoder_threads = *decoder_threads_it;
+    }
+    if (auto decoders_it = conn_json.find("decoders"); decoders_it != conn_json.end() && decoders_it->is_array()) {
+        for (const auto& decoder : *decoders_it) {
+            if (decoder.is_string()) {
+                decoders.push_back(decoder);
+            }
+        }
+    }
+    if (auto direct_rendering_it = conn_json.find("direct_rendering"); direct_rendering_it != conn_json.end() && direct_rendering_it->is_boolean()) {
+        direct_rendering = *direct_rendering_it;
+    }
+    if (auto latency_profile_it = conn_json.find("latency_profile"); latency_profile_it != conn_json.end() && latency_profile_it->is_string()) {
+        latency_profile = *latency_profile_it;
+    }
+    if (auto error_concealment_it = conn_json.find("error_concealment"); error_concealment_it != conn_json.end() && error_concealment_it->is_string()) {
+        error_concealment = *error_concealment_it;
+    }
+    if (auto fec_it = conn_json.find("fec"); fec_it != conn_json.end() && fec_it->is_boolean()) {
+        fec = *fec_it;
+    }
+    if (auto video_codecs_it = conn_json.find("video_codecs"); video_codecs_it != conn_json.end() && video_codecs_it->is_array()) {
+        std::vector<VideoCodec> parsed_video_codecs;
+        for (const auto& video_codec : *video_codecs_it) {
+            if (!video_codec.is_string()) continue;
+            if (auto codec = parse_video_codec(video_codec.get<std::string>()); codec && std::find(parsed_video_codecs.begin(), parsed_video_codecs.end(), *codec) == parsed_video_codecs.end()) {
+                parsed_video_codecs.push_back(*codec);
+            }
+        }
+        if (!parsed_video_codecs.empty()) {
+            video_codecs = std::move(parsed_video_codecs);
+        }
+    }
+    if (auto max_av_skew_it = conn_json.find("max_av_skew"); max_av_skew_it != conn_json.end() && max_av_skew_it->is_number_unsigned()) {
+        max_av_skew = *max_av_skew_it;
+    }
 }
 
 json ConnectionInfo::to_json() const {
+    json video_codecs_json = json::array();
+    for (VideoCodec codec : video_codecs) {
+        video_codecs_json.push_back(video_codec_name(codec));
+    }
+
     return {
         {"address", address},
         {"password", password},
@@ -32,5 +135,19 @@ json ConnectionInfo::to_json() const {
         {"client_side_mouse", client_side_mouse},
         {"view_only", view_only},
         {"verify_certs", verify_certs},
+        {"trickle_ice", trickle_ice},
+        {"prepare_on_select", prepare_on_select},
+        {"adaptive_bitrate", adaptive_bitrate},
+        {"min_bitrate", min_bitrate},
+        {"max_bitrate", max_bitrate},
+        {"decoder_profile", decoder_profile},
+        {"decoder_threads", decoder_threads},
+        {"decoders", decoders},
+        {"direct_rendering", direct_rendering},
+        {"latency_profile", latency_profile},
+        {"error_concealment", error_concealment},
+        {"fec", fec},
+        {"video_codecs", video_codecs_json},
+        {"max_av_skew", max_av_skew},
     };
 }
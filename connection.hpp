@@ -1,8 +1,37 @@
 #pragma once
 
 #include "json_fwd.hpp"
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
+
+enum class DecoderProfile {
+    Auto,
+    LowLatency, // Slice threading, which never holds frames back
+    Throughput, // Frame threading, which adds a frame of latency per thread
+};
+
+enum class ErrorConcealment {
+    ShowCorrupt,      // Keep displaying frames with missing references until a keyframe repairs them
+    FreezeOnLastGood, // Hold the last intact frame until a keyframe arrives
+};
+
+enum class LatencyProfile {
+    Competitive, // No buffering or clock sync, late frames are dropped
+    Balanced,
+    Smooth,
+};
+
+enum class VideoCodec {
+    H264,
+    H265,
+    AV1,
+    VP9,
+};
+
+const char* video_codec_name(VideoCodec codec);
+std::optional<VideoCodec> parse_video_codec(const std::string& name);
 
 class ConnectionInfo {
 public:
@@ -12,6 +41,20 @@ public:
     bool client_side_mouse = true;
     bool view_only = false;
     bool verify_certs = true;
+    bool trickle_ice = false;       // Sends the offer before gathering completes and exchanges candidates afterwards, which the server must support
+    bool prepare_on_select = false; // Starts gathering candidates and resolving the address as soon as the connection is selected
+    bool adaptive_bitrate = false;
+    unsigned int min_bitrate = 1000;
+    unsigned int max_bitrate = 10000;
+    DecoderProfile decoder_profile = DecoderProfile::Auto;
+    unsigned int decoder_threads = 0;  // 0 lets the decoder decide
+    std::vector<std::string> decoders; // Element names tried before the platform defaults, skipped if they can't decode the negotiated codec
+    bool direct_rendering = false;     // Off unless chosen, since not every decoder and sink agree on a pool it can use
+    LatencyProfile latency_profile = LatencyProfile::Competitive;
+    ErrorConcealment error_concealment = ErrorConcealment::ShowCorrupt;
+    bool fec = false;
+    std::vector<VideoCodec> video_codecs = {VideoCodec::H264}; // In order of preference, never empty
+    unsigned int max_av_skew = 40;                             // In milliseconds
 
     ConnectionInfo() = default;
     ConnectionInfo(std::string address, std::string password, unsigned int bitrate = 4000, bool client_side_mouse = true, bool view_only = false, bool verify_certs = true):
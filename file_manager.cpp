@@ -10,6 +10,7 @@
 #include <iostream>
 #include <sstream>
 #include <utility>
+#include <vector>
 #ifdef _WIN32
     #include "theme.hpp"
     #include <FL/x.H>
@@ -18,6 +19,15 @@
 using nlohmann::json;
 
 constexpr auto PROGRESS_UPDATE_INTERVAL = std::chrono::milliseconds(250);
+constexpr float RESUME_TIMEOUT = 30.f; // In seconds, from when the channel was replaced, so it includes reconnecting
+
+// Messages exchanged over the ordered channel:
+// - requesttransfer {id, size?}: Starts an upload when size is present, and a download otherwise
+// - transferready {id, size?, offset?}: The server is ready, with size for downloads and offset when answering resumetransfer
+// - canceltransfer {id}: Sent by either side to abandon a transfer
+// - resumetransfer {id, offset}: Sent for each paused transfer once a replacement channel opens, with the bytes that were sent or received so far
+//   The server answers with transferready carrying the offset it continues from, which may be lower, or with canceltransfer
+//   Servers that don't support it ignore it, so transfers are cancelled once RESUME_TIMEOUT runs out
 
 ProgressWindow::ProgressWindow(const std::string& path, uint64_t value, uint64_t size, std::function<void()> cancel_cb):
     Fl_Double_Window(500, 120, "File Transfer") {
@@ -51,6 +61,38 @@ void ProgressWindow::value(float value) {
     progress->copy_label(ss.str().c_str());
 }
 
+void FileManager::attach_channel() {
+    channel->setBufferedAmountLowThreshold(256 * 1024);
+    channel->onOpen(std::bind(&FileManager::on_open, this));
+    channel->onBufferedAmountLow(std::bind(&FileManager::on_buffered_amount_low, this));
+    channel->onMessage(std::bind(&FileManager::on_binary_message, this, std::placeholders::_1), std::bind(&FileManager::on_string_message, this, std::placeholders::_1));
+}
+
+void FileManager::on_open() {
+    // Chunks that were still buffered when the old channel failed never arrived, so the server decides where each transfer continues from
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& transfer : incoming_transfers) {
+        if (transfer.second->resuming) {
+            json message = {
+                {"type", "resumetransfer"},
+                {"id", transfer.first},
+                {"offset", transfer.second->received.load()},
+            };
+            channel->send(message.dump());
+        }
+    }
+    for (const auto& transfer : outgoing_transfers) {
+        if (transfer.second->resuming) {
+            json message = {
+                {"type", "resumetransfer"},
+                {"id", transfer.first},
+                {"offset", transfer.second->sent.load()},
+            };
+            channel->send(message.dump());
+        }
+    }
+}
+
 void FileManager::on_buffered_amount_low() {
     if (!buffered_amount_low_running) {
         buffered_amount_low_running = true;
@@ -58,7 +100,7 @@ void FileManager::on_buffered_amount_low() {
         std::lock_guard<std::mutex> lock(mutex);
         while (channel->bufferedAmount() <= 512 * 1024 && !outgoing_transfers.empty()) {
             for (auto transfer_it = outgoing_transfers.begin(); transfer_it != outgoing_transfers.end();) {
-                if (transfer_it->second->progress_window) {
+                if (transfer_it->second->progress_window && !transfer_it->second->resuming) {
                     rtc::binary message(chunk_size + 4);
                     if (transfer_it->second->file.read((char*) message.data() + 4, chunk_size).bad() && !transfer_it->second->file.eof()) {
                         uint32_t id = transfer_it->first;
@@ -148,9 +190,25 @@ void FileManager::on_string_message(rtc::string message) {
         if (message_json["type"] == "transferready") {
             if (message_json.contains("size")) {
                 if (auto transfer_it = incoming_transfers.find(message_json["id"]); transfer_it != incoming_transfers.end()) {
+                    if (transfer_it->second->resuming) {
+                        // Anything written past the offset is overwritten as the server sends it again
+                        uint64_t offset = message_json.value("offset", UINT64_MAX);
+                        if (offset > transfer_it->second->received || transfer_it->second->file.seekp(offset).fail()) {
+                            uint32_t id = transfer_it->first;
+                            incoming_transfers.erase(transfer_it);
+                            cancel_transfer(id);
+                            awake([id]() {
+                                fl_alert("Error: File transfer #%" PRIu32 " failed", id);
+                            });
+                            return;
+                        }
+                        transfer_it->second->received = offset;
+                        transfer_it->second->resuming = false;
+                    }
+
                     transfer_it->second->size = message_json["size"];
                     awake([this, id = transfer_it->first, weak_transfer = std::weak_ptr<IncomingTransfer>(transfer_it->second)]() {
-                        if (auto transfer = weak_transfer.lock()) {
+                        if (auto transfer = weak_transfer.lock(); transfer && !transfer->progress_window) {
                             transfer->progress_window = new ProgressWindow(transfer->path, transfer->received, transfer->size, [this, id]() {
                                 std::lock_guard<std::mutex> lock(mutex);
                                 incoming_transfers.erase(id);
@@ -167,8 +225,25 @@ void FileManager::on_string_message(rtc::string message) {
                 }
             } else {
                 if (auto transfer_it = outgoing_transfers.find(message_json["id"]); transfer_it != outgoing_transfers.end()) {
+                    if (transfer_it->second->resuming) {
+                        // The end of the file may have been reached before the old channel failed
+                        uint64_t offset = message_json.value("offset", UINT64_MAX);
+                        transfer_it->second->file.clear();
+                        if (offset > transfer_it->second->sent || transfer_it->second->file.seekg(offset).fail()) {
+                            uint32_t id = transfer_it->first;
+                            outgoing_transfers.erase(transfer_it);
+                            cancel_transfer(id);
+                            awake([id]() {
+                                fl_alert("Error: File transfer #%" PRIu32 " failed", id);
+                            });
+                            return;
+                        }
+                        transfer_it->second->sent = offset;
+                        transfer_it->second->resuming = false;
+                    }
+
                     awake([this, id = transfer_it->first, weak_transfer = std::weak_ptr<OutgoingTransfer>(transfer_it->second)]() {
-                        if (auto transfer = weak_transfer.lock()) {
+                        if (auto transfer = weak_transfer.lock(); transfer && !transfer->progress_window) {
                             transfer->progress_window = new ProgressWindow(transfer->path, transfer->sent, transfer->size, [this, id]() {
                                 std::lock_guard<std::mutex> lock(mutex);
                                 outgoing_transfers.erase(id);
@@ -233,6 +308,30 @@ void FileManager::on_string_message(rtc::string message) {
     }
 }
 
+void FileManager::resume_timer_callback(void* data) {
+    auto file_manager = (FileManager*) data;
+
+    std::vector<uint32_t> ids;
+    {
+        std::lock_guard<std::mutex> lock(file_manager->mutex);
+        std::erase_if(file_manager->incoming_transfers, [&ids](const auto& transfer) {
+            if (transfer.second->resuming) ids.push_back(transfer.first);
+            return transfer.second->resuming;
+        });
+        std::erase_if(file_manager->outgoing_transfers, [&ids](const auto& transfer) {
+            if (transfer.second->resuming) ids.push_back(transfer.first);
+            return transfer.second->resuming;
+        });
+        for (uint32_t id : ids) {
+            file_manager->cancel_transfer(id);
+        }
+    }
+
+    for (uint32_t id : ids) {
+        fl_alert("Error: File transfer #%" PRIu32 " could not be resumed", id);
+    }
+}
+
 void FileManager::cancel_transfer(uint32_t id) {
     if (channel->isOpen()) {
         json message = {
@@ -244,6 +343,8 @@ void FileManager::cancel_transfer(uint32_t id) {
 }
 
 FileManager::~FileManager() {
+    Fl::remove_timeout(resume_timer_callback, this);
+    channel->onOpen(nullptr);
     channel->onMessage(nullptr, nullptr);
     channel->onBufferedAmountLow(nullptr);
 
@@ -273,6 +374,27 @@ FileManager::~FileManager() {
     lock.unlock();
 }
 
+void FileManager::set_channel(std::shared_ptr<rtc::DataChannel> channel) {
+    this->channel->onOpen(nullptr);
+    this->channel->onMessage(nullptr, nullptr);
+    this->channel->onBufferedAmountLow(nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& transfer : incoming_transfers) {
+            transfer.second->resuming = true;
+        }
+        for (auto& transfer : outgoing_transfers) {
+            transfer.second->resuming = true;
+        }
+        this->channel = std::move(channel);
+    }
+    attach_channel();
+
+    Fl::remove_timeout(resume_timer_callback, this);
+    Fl::add_timeout(RESUME_TIMEOUT, resume_timer_callback, this);
+}
+
 void FileManager::upload() {
     if (const char* filename = fl_file_chooser("Choose File", nullptr, nullptr, 0); filename) {
         auto transfer = std::make_shared<OutgoingTransfer>();
@@ -34,6 +34,7 @@ struct IncomingTransfer {
     std::string path;
     uint64_t size;
     std::atomic<uint64_t> received = 0;
+    bool resuming = false; // Paused until the server confirms where to continue from after the channel was replaced
     ProgressWindow* progress_window = nullptr;
     std::chrono::steady_clock::time_point last_progress_update = std::chrono::steady_clock::now();
 
@@ -51,6 +52,7 @@ struct OutgoingTransfer {
     std::string path;
     uint64_t size;
     std::atomic<uint64_t> sent = 0;
+    bool resuming = false; // Paused until the server confirms where to continue from after the channel was replaced
     ProgressWindow* progress_window = nullptr;
     std::chrono::steady_clock::time_point last_progress_update = std::chrono::steady_clock::now();
 
@@ -74,22 +76,29 @@ protected:
     std::unordered_map<uint32_t, std::shared_ptr<OutgoingTransfer>> outgoing_transfers;
     std::atomic<bool> buffered_amount_low_running = false;
 
+    void attach_channel();
+    void on_open();
     void on_buffered_amount_low();
     void on_binary_message(rtc::binary message);
     void on_string_message(rtc::string message);
     void cancel_transfer(uint32_t id);
 
+    static void resume_timer_callback(void* data);
+
 public:
     FileManager(std::shared_ptr<rtc::DataChannel> channel, uint64_t chunk_size = 16384):
         channel(std::move(channel)),
         chunk_size(chunk_size) {
-        this->channel->setBufferedAmountLowThreshold(256 * 1024);
-        this->channel->onBufferedAmountLow(std::bind(&FileManager::on_buffered_amount_low, this));
-        this->channel->onMessage(std::bind(&FileManager::on_binary_message, this, std::placeholders::_1), std::bind(&FileManager::on_string_message, this, std::placeholders::_1));
+        attach_channel();
     }
 
     ~FileManager();
 
+    // Moves transfers over to the channel of a re-established connection
+    // Transfers that were in flight are paused until the server says where to resume them from, and cancelled if it can't or doesn't answer in time
+    // Must be called from the main thread
+    void set_channel(std::shared_ptr<rtc::DataChannel> channel);
+
     void upload();
     void download();
 
@@ -0,0 +1,252 @@
+#include "health.hpp"
+#include "json.hpp"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using nlohmann::json;
+
+constexpr auto PING_INTERVAL = std::chrono::milliseconds(500);
+constexpr auto PING_TIMEOUT = std::chrono::seconds(2); // Also how long pongs may stop arriving before the connection is degraded
+constexpr double RTT_SMOOTHING = 0.2;
+
+const char* health_state_name(HealthState state) {
+    switch (state) {
+    case HealthState::Connecting:
+        return "Connecting";
+
+    case HealthState::Healthy:
+        return "Healthy";
+
+    case HealthState::Degraded:
+        return "Degraded";
+
+    case HealthState::Stalled:
+        return "Stalled";
+
+    case HealthState::Failed:
+        return "Failed";
+
+    default:
+        return "Unknown";
+    }
+}
+
+HealthMonitor::HealthMonitor(std::chrono::milliseconds stall_timeout, double degraded_rtt):
+    stall_timeout(stall_timeout),
+    degraded_rtt(degraded_rtt) {
+    thread = std::thread(&HealthMonitor::run, this);
+}
+
+HealthMonitor::~HealthMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    cv.notify_all();
+    thread.join();
+
+    if (ping_channel) {
+        ping_channel->onMessage(nullptr, nullptr);
+    }
+}
+
+// Zero if nothing has arrived since the connection was attached
+std::chrono::steady_clock::time_point HealthMonitor::get_last_packet_time() const {
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_packet_time.load(std::memory_order_relaxed)));
+}
+
+HealthState HealthMonitor::evaluate(std::chrono::steady_clock::time_point now) const {
+    if (conn_state == rtc::PeerConnection::State::Failed || conn_state == rtc::PeerConnection::State::Closed ||
+        ice_state == rtc::PeerConnection::IceState::Failed || ice_state == rtc::PeerConnection::IceState::Closed) {
+        return HealthState::Failed;
+    } else if (ice_state == rtc::PeerConnection::IceState::Disconnected) {
+        return HealthState::Stalled;
+    } else if (ice_state != rtc::PeerConnection::IceState::Connected && ice_state != rtc::PeerConnection::IceState::Completed) {
+        return HealthState::Connecting;
+    }
+
+    // Media can only stall once it has started, and is judged by its silence alone so that a stall is reported within a few frame intervals
+    // Silent media may only mean that the server has nothing to send, which a ping answered during the silence shows
+    if (auto last_packet = get_last_packet_time(); last_packet != std::chrono::steady_clock::time_point() && now - last_packet >= stall_timeout) {
+        return last_answered_ping_time > last_packet ? HealthState::Degraded : HealthState::Stalled;
+    }
+
+    if (last_pong_time != std::chrono::steady_clock::time_point() && (now - last_pong_time >= PING_TIMEOUT || stats.rtt > degraded_rtt)) {
+        return HealthState::Degraded;
+    }
+    return HealthState::Healthy;
+}
+
+void HealthMonitor::update(std::unique_lock<std::mutex>& lock) {
+    auto now = std::chrono::steady_clock::now();
+    HealthState state = evaluate(now);
+    auto last_packet = get_last_packet_time();
+    silent.store(last_packet != std::chrono::steady_clock::time_point() && now - last_packet >= stall_timeout, std::memory_order_relaxed);
+
+    // Losing ICE consent during a media stall doesn't change the state, but it is handled differently
+    bool ice_disconnected_changed = ice_disconnected != (ice_state == rtc::PeerConnection::IceState::Disconnected);
+    ice_disconnected = ice_state == rtc::PeerConnection::IceState::Disconnected;
+    if (state == stats.state && (state != HealthState::Stalled || !ice_disconnected_changed)) return;
+
+    if (state == HealthState::Stalled && stats.state != HealthState::Stalled) {
+        stats.stalls++;
+    }
+    stats.state = state;
+
+    std::vector<Subscriber> subscribers;
+    for (const auto& subscriber : this->subscribers) {
+        subscribers.push_back(subscriber.second);
+    }
+    lock.unlock();
+    for (const auto& subscriber : subscribers) {
+        subscriber(state);
+    }
+    lock.lock();
+}
+
+void HealthMonitor::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto next_ping = std::chrono::steady_clock::now();
+    while (!stopped) {
+        if (auto now = std::chrono::steady_clock::now(); now >= next_ping) {
+            next_ping = now + PING_INTERVAL;
+
+            // Pings that were lost would otherwise pile up
+            std::erase_if(pending_pings, [now](const auto& ping) {
+                return now - ping.second >= PING_TIMEOUT;
+            });
+
+            if (ping_channel && ping_channel->isOpen()) {
+                uint32_t id = next_ping_id++;
+                pending_pings[id] = now;
+                last_ping_time = now;
+                stats.pings_sent++;
+
+                json message = {
+                    {"type", "ping"},
+                    {"id", id},
+                };
+                auto channel = ping_channel;
+                lock.unlock();
+                channel->send(message.dump());
+                lock.lock();
+                continue;
+            }
+        }
+
+        update(lock);
+        if (stopped) break;
+
+        // Media just went silent, so a ping goes out right away instead of at the next interval
+        if (auto last_packet = get_last_packet_time(); silent.load(std::memory_order_relaxed) && last_ping_time < last_packet && ping_channel && ping_channel->isOpen()) {
+            next_ping = last_packet;
+            continue;
+        }
+
+        // Wakes up exactly when the stall timeout would run out if nothing else arrives
+        auto deadline = next_ping;
+        if (auto last_packet = get_last_packet_time(); last_packet != std::chrono::steady_clock::time_point() && !silent.load(std::memory_order_relaxed)) {
+            deadline = std::min(deadline, last_packet + std::chrono::duration_cast<std::chrono::steady_clock::duration>(stall_timeout));
+        }
+        cv.wait_until(lock, deadline);
+    }
+}
+
+void HealthMonitor::on_ping_message(rtc::string message) {
+    auto now = std::chrono::steady_clock::now();
+    try {
+        json message_json = json::parse(message);
+        if (message_json["type"] != "pong") return;
+        auto id = message_json["id"].get<uint32_t>();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (auto ping_it = pending_pings.find(id); ping_it != pending_pings.end()) {
+            double rtt = std::chrono::duration<double, std::milli>(now - ping_it->second).count();
+            stats.rtt = stats.rtt < 0. ? rtt : stats.rtt + (rtt - stats.rtt) * RTT_SMOOTHING;
+            stats.pongs_received++;
+            last_answered_ping_time = std::max(last_answered_ping_time, ping_it->second);
+            last_pong_time = now;
+            pending_pings.erase(ping_it);
+            update(lock);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error parsing message: " << e.what() << std::endl;
+    }
+}
+
+void HealthMonitor::attach(std::shared_ptr<rtc::DataChannel> ping_channel) {
+    std::shared_ptr<rtc::DataChannel> old_ping_channel;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        old_ping_channel = std::exchange(this->ping_channel, ping_channel);
+        conn_state = rtc::PeerConnection::State::New;
+        ice_state = rtc::PeerConnection::IceState::New;
+        last_packet_time.store(0, std::memory_order_relaxed);
+        pending_pings.clear();
+        last_ping_time = {};
+        last_answered_ping_time = {};
+        last_pong_time = {};
+        stats.rtt = -1.;
+        update(lock);
+    }
+
+    // Callbacks are replaced without the lock held, since replacing one waits for it to return if it's running
+    if (old_ping_channel) {
+        old_ping_channel->onMessage(nullptr, nullptr);
+    }
+    ping_channel->onMessage(nullptr, std::bind(&HealthMonitor::on_ping_message, this, std::placeholders::_1));
+    cv.notify_one();
+}
+
+void HealthMonitor::set_stall_timeout(std::chrono::milliseconds stall_timeout) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        this->stall_timeout = stall_timeout;
+        update(lock);
+    }
+    cv.notify_one();
+}
+
+void HealthMonitor::on_state_change(rtc::PeerConnection::State state) {
+    std::unique_lock<std::mutex> lock(mutex);
+    conn_state = state;
+    update(lock);
+}
+
+void HealthMonitor::on_ice_state_change(rtc::PeerConnection::IceState state) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ice_state = state;
+    update(lock);
+}
+
+void HealthMonitor::on_packet() {
+    // The first packet and the end of a silence both change when the thread should wake up next
+    if (!last_packet_time.exchange(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed)) {
+        cv.notify_one();
+    } else if (silent.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lock(mutex);
+        update(lock);
+        lock.unlock();
+        cv.notify_one();
+    }
+}
+
+unsigned int HealthMonitor::subscribe(Subscriber subscriber) {
+    std::lock_guard<std::mutex> lock(mutex);
+    unsigned int id = next_subscriber_id++;
+    subscribers[id] = std::move(subscriber);
+    return id;
+}
+
+void HealthMonitor::unsubscribe(unsigned int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    subscribers.erase(id);
+}
+
+HealthStats HealthMonitor::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <rtc/rtc.hpp>
+#include <stdint.h>
+#include <thread>
+
+enum class HealthState {
+    Connecting, // Not established yet, including right after the connection was replaced
+    Healthy,
+    Degraded, // Pings take too long or have stopped being answered, or media is silent while pings are still answered
+    Stalled,  // No RTP has arrived within the stall timeout and no ping sent since has been answered, or ICE has lost consent to send
+    Failed,   // The connection can't recover by itself
+};
+
+struct HealthStats {
+    HealthState state = HealthState::Connecting;
+    double rtt = -1.; // Smoothed ping round trip, in milliseconds, negative if no ping has been answered yet
+    uint64_t pings_sent = 0;
+    uint64_t pongs_received = 0;
+    uint64_t stalls = 0;
+};
+
+const char* health_state_name(HealthState state);
+
+// Tracks the health of a peer connection from its state callbacks and the RTP it receives, instead of polling it
+// Pings are sent on their own unreliable channel, which the server is expected to answer with a pong carrying the same ID
+// Stalls are detected by a thread that sleeps until the moment the stall timeout would run out, so they are noticed as soon as they happen
+// That thread also sends a ping as soon as media goes silent, whose answer tells an idle server from a dead connection within a round trip
+class HealthMonitor {
+public:
+    using Subscriber = std::function<void(HealthState state)>;
+
+protected:
+    std::chrono::milliseconds stall_timeout;
+    double degraded_rtt; // In milliseconds
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    bool stopped = false;
+    std::thread thread;
+
+    std::shared_ptr<rtc::DataChannel> ping_channel;
+    rtc::PeerConnection::State conn_state = rtc::PeerConnection::State::New;
+    rtc::PeerConnection::IceState ice_state = rtc::PeerConnection::IceState::New;
+    std::atomic<std::chrono::steady_clock::rep> last_packet_time = 0; // Zero if nothing has arrived since the connection was attached
+    std::atomic<bool> silent = false;
+    bool ice_disconnected = false; // As of the last update, since it changes how a stall is handled
+    uint32_t next_ping_id = 0;
+    std::map<uint32_t, std::chrono::steady_clock::time_point> pending_pings;
+    std::chrono::steady_clock::time_point last_ping_time;
+    std::chrono::steady_clock::time_point last_answered_ping_time; // When the last answered ping was sent
+    std::chrono::steady_clock::time_point last_pong_time;
+    HealthStats stats;
+
+    unsigned int next_subscriber_id = 0;
+    std::map<unsigned int, Subscriber> subscribers;
+
+    std::chrono::steady_clock::time_point get_last_packet_time() const;
+    HealthState evaluate(std::chrono::steady_clock::time_point now) const;
+    void update(std::unique_lock<std::mutex>& lock);
+    void run();
+    void on_ping_message(rtc::string message);
+
+public:
+    HealthMonitor(std::chrono::milliseconds stall_timeout, double degraded_rtt);
+    HealthMonitor(const HealthMonitor&) = delete;
+    HealthMonitor(HealthMonitor&&) = delete;
+
+    HealthMonitor& operator=(const HealthMonitor&) = delete;
+    HealthMonitor& operator=(HealthMonitor&&) = delete;
+
+    ~HealthMonitor();
+
+    // Starts over for a new connection, which must no longer report the old one's states
+    void attach(std::shared_ptr<rtc::DataChannel> ping_channel);
+
+    // Called once the stream's frame and packet intervals are known
+    void set_stall_timeout(std::chrono::milliseconds stall_timeout);
+
+    // Called from the connection's threads
+    void on_state_change(rtc::PeerConnection::State state);
+    void on_ice_state_change(rtc::PeerConnection::IceState state);
+
+    // Called for every incoming RTP packet, so it only takes a lock while media is silent
+    void on_packet();
+
+    // Subscribers are called from whichever thread noticed the change, without the monitor's lock held
+    unsigned int subscribe(Subscriber subscriber);
+    void unsubscribe(unsigned int id);
+
+    HealthStats get_stats() const;
+};
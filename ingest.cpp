@@ -0,0 +1,203 @@
+#include "ingest.hpp"
+#include <cstddef>
+#include <utility>
+
+struct PacketPoolCounters {
+    std::atomic<uint64_t> allocations = 0;
+    std::atomic<unsigned int> outstanding = 0;
+    std::atomic<unsigned int> high_water = 0;
+    std::atomic<bool> tracking = false;
+};
+
+// A GstBufferPool of empty buffers that keeps track of how many of them are in flight
+struct LuxPacketPool {
+    GstBufferPool parent;
+    PacketPoolCounters* counters;
+};
+
+struct LuxPacketPoolClass {
+    GstBufferPoolClass parent_class;
+};
+
+G_DEFINE_TYPE(LuxPacketPool, lux_packet_pool, GST_TYPE_BUFFER_POOL)
+
+static GstFlowReturn lux_packet_pool_alloc_buffer(GstBufferPool* pool, GstBuffer** buffer, GstBufferPoolAcquireParams*) {
+    ((LuxPacketPool*) pool)->counters->allocations++;
+    *buffer = gst_buffer_new();
+    return GST_FLOW_OK;
+}
+
+static void lux_packet_pool_reset_buffer(GstBufferPool* pool, GstBuffer* buffer) {
+    // Freeing the packet's memory here lets the buffer pass the pool's size check, and the memory tag would make the pool discard it
+    gst_buffer_remove_all_memory(buffer);
+    GST_BUFFER_POOL_CLASS(lux_packet_pool_parent_class)->reset_buffer(pool, buffer);
+    GST_BUFFER_FLAG_UNSET(buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+}
+
+static void lux_packet_pool_release_buffer(GstBufferPool* pool, GstBuffer* buffer) {
+    // Preallocated buffers are also released into the pool when it is activated
+    if (auto counters = ((LuxPacketPool*) pool)->counters; counters->tracking) {
+        counters->outstanding--;
+    }
+    GST_BUFFER_POOL_CLASS(lux_packet_pool_parent_class)->release_buffer(pool, buffer);
+}
+
+static void lux_packet_pool_finalize(GObject* object) {
+    delete ((LuxPacketPool*) object)->counters;
+    G_OBJECT_CLASS(lux_packet_pool_parent_class)->finalize(object);
+}
+
+static void lux_packet_pool_class_init(LuxPacketPoolClass* klass) {
+    G_OBJECT_CLASS(klass)->finalize = lux_packet_pool_finalize;
+    GST_BUFFER_POOL_CLASS(klass)->alloc_buffer = lux_packet_pool_alloc_buffer;
+    GST_BUFFER_POOL_CLASS(klass)->reset_buffer = lux_packet_pool_reset_buffer;
+    GST_BUFFER_POOL_CLASS(klass)->release_buffer = lux_packet_pool_release_buffer;
+}
+
+static void lux_packet_pool_init(LuxPacketPool* pool) {
+    pool->counters = new PacketPoolCounters;
+}
+
+PacketPool::PacketPool(unsigned int min_buffers, unsigned int max_buffers):
+    pool((GstBufferPool*) gst_object_ref_sink(g_object_new(lux_packet_pool_get_type(), nullptr))) {
+    counters = ((LuxPacketPool*) pool.get())->counters;
+
+    GstStructure* config = gst_buffer_pool_get_config(pool.get());
+    gst_buffer_pool_config_set_params(config, nullptr, 0, min_buffers, max_buffers);
+    gst_buffer_pool_set_config(pool.get(), config);
+    gst_buffer_pool_set_active(pool.get(), TRUE);
+    counters->tracking = true;
+}
+
+PacketPool::~PacketPool() {
+    // Buffers still owned by the pipeline keep the pool alive, and are freed rather than recycled once it is inactive
+    gst_buffer_pool_set_active(pool.get(), FALSE);
+}
+
+GstBuffer* PacketPool::acquire() {
+    GstBufferPoolAcquireParams params {};
+    params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+
+    // Acquisition only happens on the track's receive thread, so a change here means this call allocated
+    uint64_t allocations = counters->allocations;
+    GstBuffer* buf;
+    if (gst_buffer_pool_acquire_buffer(pool.get(), &buf, &params) != GST_FLOW_OK) {
+        misses++;
+        return gst_buffer_new();
+    }
+    if (counters->allocations == allocations) {
+        hits++;
+    } else {
+        misses++;
+    }
+
+    unsigned int outstanding = ++counters->outstanding;
+    for (unsigned int high_water = counters->high_water; outstanding > high_water && !counters->high_water.compare_exchange_weak(high_water, outstanding);) {}
+    return buf;
+}
+
+uint64_t PacketPool::get_hits() const {
+    return hits;
+}
+
+uint64_t PacketPool::get_misses() const {
+    return misses;
+}
+
+unsigned int PacketPool::get_high_water() const {
+    return counters->high_water;
+}
+
+GstBuffer* TrackIngest::make_buffer(rtc::binary message) {
+    size_t size = message.size();
+
+    // The memory takes ownership of the vector's storage and frees it when the buffer returns to the pool
+    // libdatachannel allocates that storage for every message, so only the buffer around it can be recycled
+    auto storage = new rtc::binary(std::move(message));
+    GstBuffer* buf = pool.acquire();
+    gst_buffer_append_memory(buf,
+        gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY,
+            storage->data(),
+            size,
+            0,
+            size,
+            storage,
+            [](void* data) {
+                delete (rtc::binary*) data;
+            }));
+
+    // Every buffer carries its arrival time, since appsrc doesn't stamp buffers in lists and the video appsrc doesn't stamp any
+    GST_BUFFER_DTS(buf) = running_time();
+    return buf;
+}
+
+GstClockTime TrackIngest::running_time() const {
+    if (glib::Object<GstClock> clock = gst_element_get_clock(appsrc.get())) {
+        return gst_clock_get_time(clock.get()) - gst_element_get_base_time(appsrc.get());
+    }
+    return GST_CLOCK_TIME_NONE;
+}
+
+void TrackIngest::flush_frame() {
+    if (pending_frame) {
+        frames.add();
+        gst_app_src_push_buffer_list(GST_APP_SRC(appsrc.get()), pending_frame); // Takes ownership of pending_frame
+        pending_frame = nullptr;
+    }
+}
+
+void TrackIngest::push(rtc::binary message) {
+    if (message.empty()) return;
+    size_t size = message.size();
+    packets.add();
+    bytes.add(size);
+
+    if (size < 12) {
+        gst_app_src_push_buffer(GST_APP_SRC(appsrc.get()), make_buffer(std::move(message))); // Takes ownership of the buffer
+        return;
+    }
+
+    bool marker = std::to_integer<uint8_t>(message[1]) & 0x80;
+    uint32_t timestamp = (std::to_integer<uint32_t>(message[4]) << 24) |
+                         (std::to_integer<uint32_t>(message[5]) << 16) |
+                         (std::to_integer<uint32_t>(message[6]) << 8) |
+                         std::to_integer<uint32_t>(message[7]);
+
+    if (latency_tracker) {
+        latency_tracker->on_packet_arrival(timestamp);
+    }
+
+    if (!batch_frames) {
+        gst_app_src_push_buffer(GST_APP_SRC(appsrc.get()), make_buffer(std::move(message))); // Takes ownership of the buffer
+        return;
+    }
+
+    // A new timestamp before a marker means that the end of the last frame was lost
+    if (pending_frame && (timestamp != pending_timestamp || gst_buffer_list_length(pending_frame) >= 1024)) {
+        flush_frame();
+    }
+
+    GstBuffer* buf = make_buffer(std::move(message));
+    if (!pending_frame) {
+        pending_frame = gst_buffer_list_new();
+        pending_timestamp = timestamp;
+    }
+    gst_buffer_list_add(pending_frame, buf);
+
+    if (marker) {
+        flush_frame();
+    }
+}
+
+IngestStats TrackIngest::stats() {
+    return {
+        .packets = packets.get_total(),
+        .bytes = bytes.get_total(),
+        .packets_per_second = packets.rate(),
+        .bytes_per_second = bytes.rate(),
+        .frames_per_second = frames.rate(),
+        .pool_hits = pool.get_hits(),
+        .pool_misses = pool.get_misses(),
+        .pool_high_water = pool.get_high_water(),
+    };
+}
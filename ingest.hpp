@@ -0,0 +1,97 @@
+#pragma once
+
+#include "glib.hpp"
+#include "latency.hpp"
+#include "stats.hpp"
+#include <atomic>
+#include <gst/app/gstappsrc.h>
+#include <gst/gst.h>
+#include <memory>
+#include <rtc/rtc.hpp>
+#include <stddef.h>
+#include <stdint.h>
+
+struct IngestStats {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    double packets_per_second = 0.;
+    double bytes_per_second = 0.;
+    double frames_per_second = 0.;
+    uint64_t pool_hits = 0;
+    uint64_t pool_misses = 0;
+    unsigned int pool_high_water = 0; // Most buffers in flight at once
+};
+
+struct PacketPoolCounters;
+
+// Recycles the GstBuffers that wrap received packets, so that only the packet's own memory is allocated per packet
+// The buffers have no memory of their own; whatever was appended to them is dropped when they return to the pool
+class PacketPool {
+protected:
+    glib::Object<GstBufferPool> pool;
+    PacketPoolCounters* counters; // Owned by the pool, which may outlive this object
+
+    std::atomic<uint64_t> hits = 0;
+    std::atomic<uint64_t> misses = 0;
+
+public:
+    PacketPool(unsigned int min_buffers, unsigned int max_buffers);
+    PacketPool(const PacketPool&) = delete;
+    PacketPool(PacketPool&&) = delete;
+
+    PacketPool& operator=(const PacketPool&) = delete;
+    PacketPool& operator=(PacketPool&&) = delete;
+
+    ~PacketPool();
+
+    // Falls back to a fresh buffer if the pool is exhausted
+    GstBuffer* acquire();
+    uint64_t get_hits() const;
+    uint64_t get_misses() const;
+    unsigned int get_high_water() const;
+};
+
+// Moves RTP packets received on a track into an appsrc without copying them
+// When batching is enabled, packets are grouped up to the RTP marker bit and pushed one frame at a time
+class TrackIngest {
+protected:
+    glib::Object<GstElement> appsrc;
+    PacketPool pool;
+
+    bool batch_frames;
+    GstBufferList* pending_frame = nullptr;
+    uint32_t pending_timestamp = 0;
+
+    std::shared_ptr<LatencyTracker> latency_tracker;
+
+    RateCounter packets;
+    RateCounter bytes;
+    RateCounter frames;
+
+    GstBuffer* make_buffer(rtc::binary message); // Stamps the buffer with its arrival time
+    GstClockTime running_time() const;
+    void flush_frame();
+
+public:
+    TrackIngest(GstElement* appsrc, bool batch_frames = false, unsigned int min_buffers = 16, unsigned int max_buffers = 256):
+        appsrc((GstElement*) gst_object_ref(appsrc)),
+        pool(min_buffers, max_buffers),
+        batch_frames(batch_frames) {}
+    TrackIngest(const TrackIngest&) = delete;
+    TrackIngest(TrackIngest&&) = delete;
+
+    TrackIngest& operator=(const TrackIngest&) = delete;
+    TrackIngest& operator=(TrackIngest&&) = delete;
+
+    ~TrackIngest() {
+        if (pending_frame) gst_buffer_list_unref(pending_frame);
+    }
+
+    // Must be called before packets start arriving
+    void set_latency_tracker(std::shared_ptr<LatencyTracker> latency_tracker) {
+        this->latency_tracker = std::move(latency_tracker);
+    }
+
+    void push(rtc::binary message);
+    IngestStats stats();
+};
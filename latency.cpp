@@ -0,0 +1,171 @@
+#include "latency.hpp"
+#include "glib.hpp"
+#include <gst/base/gstbasesink.h>
+#include <math.h>
+
+static double milliseconds_between(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+LatencyTracker::Frame* LatencyTracker::find_by_rtp_timestamp(uint32_t rtp_timestamp) {
+    for (auto& frame : frames) {
+        if (frame.used && frame.rtp_timestamp == rtp_timestamp) {
+            return &frame;
+        }
+    }
+    return nullptr;
+}
+
+LatencyTracker::Frame* LatencyTracker::find_by_pts(GstClockTime pts) {
+    if (!GST_CLOCK_TIME_IS_VALID(pts)) return nullptr;
+    for (auto& frame : frames) {
+        if (frame.used && frame.pts == pts) {
+            return &frame;
+        }
+    }
+    return nullptr;
+}
+
+void LatencyTracker::on_packet_arrival(uint32_t rtp_timestamp) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!find_by_rtp_timestamp(rtp_timestamp)) {
+        auto now = std::chrono::steady_clock::now();
+        frames[next_frame] = {
+            .used = true,
+            .rtp_timestamp = rtp_timestamp,
+            .arrival = now,
+        };
+        next_frame = (next_frame + 1) % frames.size();
+
+        // Frames that arrive out of order step the timestamp back, which the signed difference handles
+        if (!has_first_frame) {
+            has_first_frame = true;
+            first_arrival = now;
+        } else {
+            extended_rtp_timestamp += (int32_t) (rtp_timestamp - last_rtp_timestamp);
+        }
+        last_rtp_timestamp = rtp_timestamp;
+        one_way_delay_sum += milliseconds_between(first_arrival, now) - extended_rtp_timestamp * 1000. / clock_rate;
+        one_way_delay_count++;
+    }
+}
+
+void LatencyTracker::on_jitterbuffer_output(GstBuffer* buf) {
+    uint8_t header[8];
+    if (gst_buffer_extract(buf, 0, header, sizeof header) != sizeof header) return;
+    uint32_t rtp_timestamp = ((uint32_t) header[4] << 24) | ((uint32_t) header[5] << 16) | ((uint32_t) header[6] << 8) | header[7];
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (Frame* frame = find_by_rtp_timestamp(rtp_timestamp)) {
+        // Every packet of the frame passes through here, so the last one wins
+        frame->pts = GST_BUFFER_PTS(buf);
+        frame->jitterbuffer = std::chrono::steady_clock::now();
+    }
+}
+
+void LatencyTracker::on_depayloader_output(GstBuffer* buf) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (Frame* frame = find_by_pts(GST_BUFFER_PTS(buf)); frame && frame->depayload == std::chrono::steady_clock::time_point()) {
+        frame->depayload = std::chrono::steady_clock::now();
+    }
+}
+
+void LatencyTracker::on_decoder_output(GstBuffer* buf) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (Frame* frame = find_by_pts(GST_BUFFER_PTS(buf)); frame && frame->decode == std::chrono::steady_clock::time_point()) {
+        frame->decode = std::chrono::steady_clock::now();
+    }
+}
+
+void LatencyTracker::on_sink_input(GstPad* pad, GstBuffer* buf) {
+    auto now = std::chrono::steady_clock::now();
+
+    // The sink renders once the clock reaches the buffer's running time plus the pipeline latency
+    double wait = 0.;
+    glib::Object<GstElement> sink = gst_pad_get_parent_element(pad);
+    if (sink && gst_base_sink_get_sync(GST_BASE_SINK(sink.get()))) {
+        glib::Object<GstClock> clock = gst_element_get_clock(sink.get());
+        GstEvent* segment_event = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+        if (clock && segment_event) {
+            const GstSegment* segment;
+            gst_event_parse_segment(segment_event, &segment);
+
+            GstClockTime running_time = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buf));
+            if (GST_CLOCK_TIME_IS_VALID(running_time)) {
+                GstClockTime render_time = running_time + gst_base_sink_get_latency(GST_BASE_SINK(sink.get()));
+                GstClockTime clock_running_time = gst_clock_get_time(clock.get()) - gst_element_get_base_time(sink.get());
+                if (render_time > clock_running_time) {
+                    wait = (render_time - clock_running_time) / (double) GST_MSECOND;
+                }
+            }
+        }
+        if (segment_event) gst_event_unref(segment_event);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (Frame* frame = find_by_pts(GST_BUFFER_PTS(buf))) {
+        if (frame->jitterbuffer != std::chrono::steady_clock::time_point()) {
+            network.add(milliseconds_between(frame->arrival, frame->jitterbuffer));
+            if (frame->depayload != std::chrono::steady_clock::time_point()) {
+                depayload.add(milliseconds_between(frame->jitterbuffer, frame->depayload));
+                if (frame->decode != std::chrono::steady_clock::time_point()) {
+                    decode.add(milliseconds_between(frame->depayload, frame->decode));
+                }
+            }
+        }
+        render_wait.add(wait);
+        total.add(milliseconds_between(frame->arrival, now) + wait);
+        frame->used = false;
+    }
+}
+
+void LatencyTracker::attach(GstElement* jitterbuffer, GstElement* depayloader, GstElement* decoder, GstElement* sink) {
+    struct Probe {
+        GstElement* element;
+        const char* pad_name;
+        GstPadProbeCallback callback;
+    };
+
+    Probe probes[] = {
+        {jitterbuffer, "src", [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+             ((LatencyTracker*) data)->on_jitterbuffer_output(GST_PAD_PROBE_INFO_BUFFER(info));
+             return GST_PAD_PROBE_OK;
+         }},
+        {depayloader, "src", [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+             ((LatencyTracker*) data)->on_depayloader_output(GST_PAD_PROBE_INFO_BUFFER(info));
+             return GST_PAD_PROBE_OK;
+         }},
+        {decoder, "src", [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+             ((LatencyTracker*) data)->on_decoder_output(GST_PAD_PROBE_INFO_BUFFER(info));
+             return GST_PAD_PROBE_OK;
+         }},
+        {sink, "sink", [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+             ((LatencyTracker*) data)->on_sink_input(pad, GST_PAD_PROBE_INFO_BUFFER(info));
+             return GST_PAD_PROBE_OK;
+         }},
+    };
+
+    for (const auto& probe : probes) {
+        if (!probe.element) continue;
+        glib::Object<GstPad> pad = gst_element_get_static_pad(probe.element, probe.pad_name);
+        gst_pad_add_probe(pad.get(), GST_PAD_PROBE_TYPE_BUFFER, probe.callback, this, nullptr);
+    }
+}
+
+double LatencyTracker::take_one_way_delay() {
+    std::lock_guard<std::mutex> lock(mutex);
+    double one_way_delay = one_way_delay_count ? one_way_delay_sum / one_way_delay_count : NAN;
+    one_way_delay_sum = 0.;
+    one_way_delay_count = 0;
+    return one_way_delay;
+}
+
+LatencyStats LatencyTracker::stats() const {
+    return {
+        .network = network.get(),
+        .depayload = depayload.get(),
+        .decode = decode.get(),
+        .render_wait = render_wait.get(),
+        .total = total.get(),
+    };
+}
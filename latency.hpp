@@ -0,0 +1,81 @@
+#pragma once
+
+#include "stats.hpp"
+#include <array>
+#include <chrono>
+#include <gst/gst.h>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+// All durations are in milliseconds
+struct LatencyStats {
+    Percentiles network;     // First packet arrival until the jitter buffer releases the frame
+    Percentiles depayload;   // Jitter buffer until the depayloader outputs the access unit
+    Percentiles decode;      // Depayloader until the decoder outputs the picture
+    Percentiles render_wait; // Time the sink will wait on the clock before rendering
+    Percentiles total;       // First packet arrival until the frame is rendered
+};
+
+// Follows frames through the pipeline by RTP timestamp (and later PTS) using pad probes
+class LatencyTracker {
+protected:
+    struct Frame {
+        bool used = false;
+        uint32_t rtp_timestamp = 0;
+        GstClockTime pts = GST_CLOCK_TIME_NONE;
+        std::chrono::steady_clock::time_point arrival;
+        std::chrono::steady_clock::time_point jitterbuffer;
+        std::chrono::steady_clock::time_point depayload;
+        std::chrono::steady_clock::time_point decode;
+    };
+
+    unsigned int clock_rate;
+
+    std::mutex mutex;
+    std::array<Frame, 64> frames;
+    size_t next_frame = 0;
+
+    // One-way delay of each frame's first packet, as its arrival time minus its RTP time, relative to the first frame
+    bool has_first_frame = false;
+    std::chrono::steady_clock::time_point first_arrival;
+    uint32_t last_rtp_timestamp = 0;
+    int64_t extended_rtp_timestamp = 0; // Since the first frame, unwrapped
+    double one_way_delay_sum = 0.;
+    unsigned int one_way_delay_count = 0;
+
+    RollingPercentiles network;
+    RollingPercentiles depayload;
+    RollingPercentiles decode;
+    RollingPercentiles render_wait;
+    RollingPercentiles total;
+
+    Frame* find_by_rtp_timestamp(uint32_t rtp_timestamp);
+    Frame* find_by_pts(GstClockTime pts);
+
+    void on_jitterbuffer_output(GstBuffer* buf);
+    void on_depayloader_output(GstBuffer* buf);
+    void on_decoder_output(GstBuffer* buf);
+    void on_sink_input(GstPad* pad, GstBuffer* buf);
+
+public:
+    LatencyTracker(unsigned int clock_rate = 90000):
+        clock_rate(clock_rate) {}
+    LatencyTracker(const LatencyTracker&) = delete;
+    LatencyTracker(LatencyTracker&&) = delete;
+
+    LatencyTracker& operator=(const LatencyTracker&) = delete;
+    LatencyTracker& operator=(LatencyTracker&&) = delete;
+
+    // Called from the track's receive thread for every packet
+    void on_packet_arrival(uint32_t rtp_timestamp);
+
+    // The tracker must outlive the pipeline that these elements belong to
+    void attach(GstElement* jitterbuffer, GstElement* depayloader, GstElement* decoder, GstElement* sink);
+
+    LatencyStats stats() const;
+
+    // Returns the mean one-way delay of the frames that arrived since the last call, or NaN if none did
+    // The delay has an arbitrary offset, so only its changes are meaningful
+    double take_one_way_delay();
+};
@@ -13,6 +13,8 @@
     #include <stdint.h>
     #include <stdio.h>
     #include <windows.h>
+#else
+    #include <signal.h>
 #endif
 
 using nlohmann::json;
@@ -33,6 +35,9 @@ int main(int argc, char* argv[]) {
     configure_fltk_colors();
     rtc::InitLogger(rtc::LogLevel::Debug);
     (void)pn::init();
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN); // Writing to a signaling connection that the server has closed must fail instead of ending the process
+#endif
     pw::thread_pool.resize(0); // The threadpool is only used by Polyweb in server applications
     gst_init(&argc, &argv);
 
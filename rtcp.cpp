@@ -0,0 +1,468 @@
+#include "rtcp.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+constexpr size_t MAX_MISSING_PACKETS = 512;
+constexpr uint16_t MAX_SEQUENCE_GAP = 1000;
+constexpr unsigned int MAX_REQUESTS = 3;
+constexpr size_t MAX_NACK_ITEMS = 64;
+constexpr auto REORDER_DELAY = std::chrono::milliseconds(5);
+constexpr auto NACK_TIMER_INTERVAL = std::chrono::milliseconds(5);
+constexpr auto MAX_MISSING_AGE = std::chrono::seconds(1);
+constexpr double DEFAULT_RTT = 50.;
+constexpr auto MIN_KEYFRAME_REQUEST_INTERVAL = std::chrono::milliseconds(300);
+constexpr auto MAX_KEYFRAME_REQUEST_INTERVAL = std::chrono::milliseconds(5000);
+constexpr auto TWCC_FEEDBACK_INTERVAL = std::chrono::milliseconds(50);
+constexpr int64_t TWCC_MAX_STATUS_COUNT = 1000;
+
+static uint8_t get_byte(const rtc::binary& packet, size_t i) {
+    return std::to_integer<uint8_t>(packet[i]);
+}
+
+static uint16_t get_uint16(const rtc::binary& packet, size_t i) {
+    return (uint16_t) ((get_byte(packet, i) << 8) | get_byte(packet, i + 1));
+}
+
+static uint32_t get_uint32(const rtc::binary& packet, size_t i) {
+    return ((uint32_t) get_byte(packet, i) << 24) |
+           ((uint32_t) get_byte(packet, i + 1) << 16) |
+           ((uint32_t) get_byte(packet, i + 2) << 8) |
+           get_byte(packet, i + 3);
+}
+
+static void put_uint16(rtc::binary& packet, size_t i, uint16_t value) {
+    packet[i] = (std::byte) (value >> 8);
+    packet[i + 1] = (std::byte) value;
+}
+
+static void put_uint32(rtc::binary& packet, size_t i, uint32_t value) {
+    put_uint16(packet, i, value >> 16);
+    put_uint16(packet, i + 2, value);
+}
+
+RtcpTimer::RtcpTimer(std::chrono::milliseconds interval, std::function<void()> callback):
+    interval(interval),
+    callback(std::move(callback)) {
+    thread = std::thread(&RtcpTimer::run, this);
+}
+
+RtcpTimer::~RtcpTimer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    cv.notify_all();
+    thread.join();
+}
+
+void RtcpTimer::run() {
+    // Ticks are scheduled from the previous deadline, so the interval doesn't drift with the callback's run time
+    auto deadline = std::chrono::steady_clock::now() + interval;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!cv.wait_until(lock, deadline, [this]() {
+        return stopped;
+    })) {
+        lock.unlock();
+        callback();
+        lock.lock();
+        deadline = std::max(deadline + interval, std::chrono::steady_clock::now());
+    }
+}
+
+KeyframeRequester::KeyframeRequester(std::function<void()> send_request):
+    send_request(std::move(send_request)),
+    interval(MIN_KEYFRAME_REQUEST_INTERVAL) {}
+
+void KeyframeRequester::set_send_request(std::function<void()> send_request) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->send_request = std::move(send_request);
+    last_request = {};
+    interval = MIN_KEYFRAME_REQUEST_INTERVAL;
+}
+
+bool KeyframeRequester::request() {
+    std::function<void()> send_request;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_request < interval) {
+            stats.requests_suppressed++;
+            return false;
+        }
+        last_request = now;
+        interval = std::min(interval * 2, MAX_KEYFRAME_REQUEST_INTERVAL);
+        stats.requests_sent++;
+        send_request = this->send_request;
+    }
+
+    send_request();
+    return true;
+}
+
+void KeyframeRequester::on_keyframe() {
+    std::lock_guard<std::mutex> lock(mutex);
+    interval = MIN_KEYFRAME_REQUEST_INTERVAL;
+}
+
+KeyframeStats KeyframeRequester::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+NackRequester::NackRequester(std::map<uint8_t, uint8_t> rtx_payload_types, uint32_t local_ssrc):
+    rtx_payload_types(std::move(rtx_payload_types)),
+    local_ssrc(local_ssrc) {
+    timer = std::make_unique<RtcpTimer>(NACK_TIMER_INTERVAL, [this]() {
+        send_requests(std::chrono::steady_clock::now());
+    });
+}
+
+bool NackRequester::is_media_payload_type(uint8_t payload_type) const {
+    for (const auto& rtx_payload_type : rtx_payload_types) {
+        if (rtx_payload_type.second == payload_type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NackRequester::restore_rtx(rtc::binary& packet, uint8_t payload_type) {
+    if (!have_media_ssrc) return false;
+
+    size_t header_size = 12 + 4 * (get_byte(packet, 0) & 0x0F);
+    if (get_byte(packet, 0) & 0x10) {
+        if (packet.size() < header_size + 4) return false;
+        header_size += 4 + 4 * get_uint16(packet, header_size + 2);
+    }
+    size_t padding = (get_byte(packet, 0) & 0x20) ? get_byte(packet, packet.size() - 1) : 0;
+
+    // Padding-only RTX packets are bandwidth probes and carry nothing to restore
+    if (packet.size() < header_size + 2 + padding) return false;
+
+    // The RTX payload starts with the original sequence number
+    uint16_t original_seq = get_uint16(packet, header_size);
+    packet[1] = (std::byte) ((get_byte(packet, 1) & 0x80) | payload_type);
+    put_uint16(packet, 2, original_seq);
+    put_uint32(packet, 8, media_ssrc);
+    packet.erase(packet.begin() + header_size, packet.begin() + header_size + 2);
+    return true;
+}
+
+void NackRequester::on_packet(uint16_t seq, std::chrono::steady_clock::time_point now) {
+    if (int16_t diff = seq - highest_seq; diff > 0) {
+        if ((uint16_t) diff > MAX_SEQUENCE_GAP) {
+            // The sender restarted its sequence, so the old gaps are meaningless
+            missing.clear();
+        } else {
+            for (uint16_t missing_seq = highest_seq + 1; missing_seq != seq && missing.size() < MAX_MISSING_PACKETS; ++missing_seq) {
+                missing[missing_seq] = {.detected = now};
+            }
+        }
+        highest_seq = seq;
+    } else if (auto missing_it = missing.find(seq); missing_it != missing.end()) {
+        if (missing_it->second.requests) {
+            stats.packets_recovered++;
+
+            double rtt = std::chrono::duration<double, std::milli>(now - missing_it->second.last_request).count();
+            stats.rtt = stats.rtt ? stats.rtt * 0.875 + rtt * 0.125 : rtt;
+        }
+        missing.erase(missing_it);
+    }
+}
+
+void NackRequester::send_requests(std::chrono::steady_clock::time_point now) {
+    std::vector<std::pair<uint16_t, uint16_t>> items; // PID and BLP
+    uint32_t ssrc;
+    bool abandoned = false;
+    std::shared_ptr<KeyframeRequester> keyframe_requester;
+    rtc::message_callback send;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (missing.empty()) return;
+
+        auto retry_interval = std::chrono::duration<double, std::milli>((stats.rtt ? stats.rtt : DEFAULT_RTT) * 1.5);
+        for (auto missing_it = missing.begin(); missing_it != missing.end();) {
+            auto& [seq, packet] = *missing_it;
+            if (now - packet.detected >= MAX_MISSING_AGE || (packet.requests >= MAX_REQUESTS && now - packet.last_request >= retry_interval)) {
+                stats.packets_abandoned++;
+                abandoned = true;
+                missing_it = missing.erase(missing_it);
+                continue;
+            }
+
+            // A short wait avoids requesting packets that were merely reordered
+            if ((packet.requests == 0 && now - packet.detected >= REORDER_DELAY) ||
+                (packet.requests > 0 && packet.requests < MAX_REQUESTS && now - packet.last_request >= retry_interval)) {
+                if (!items.empty() && (uint16_t) (seq - items.back().first) <= 16) {
+                    items.back().second |= 1 << ((uint16_t) (seq - items.back().first) - 1);
+                } else if (items.size() < MAX_NACK_ITEMS) {
+                    items.push_back({seq, 0});
+                } else {
+                    break;
+                }
+
+                if (!packet.requests++) {
+                    stats.packets_requested++;
+                }
+                packet.last_request = now;
+            }
+            ++missing_it;
+        }
+
+        if (!items.empty()) {
+            stats.nacks_sent++;
+            ssrc = media_ssrc;
+            send = this->send;
+        }
+        if (abandoned) {
+            keyframe_requester = this->keyframe_requester;
+        }
+    }
+
+    if (keyframe_requester) {
+        keyframe_requester->request();
+    }
+    if (items.empty() || !send) return;
+
+    rtc::binary nack(12 + 4 * items.size());
+    nack[0] = (std::byte) 0x81; // Version 2, FMT 1 (generic NACK)
+    nack[1] = (std::byte) 205;  // Transport layer feedback
+    put_uint16(nack, 2, nack.size() / 4 - 1);
+    put_uint32(nack, 4, local_ssrc);
+    put_uint32(nack, 8, ssrc);
+    for (size_t i = 0; i < items.size(); ++i) {
+        put_uint16(nack, 12 + 4 * i, items[i].first);
+        put_uint16(nack, 14 + 4 * i, items[i].second);
+    }
+    send(rtc::make_message(std::move(nack), rtc::Message::Control));
+}
+
+void NackRequester::set_keyframe_requester(std::shared_ptr<KeyframeRequester> keyframe_requester) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->keyframe_requester = std::move(keyframe_requester);
+}
+
+void NackRequester::incoming(rtc::message_vector& messages, const rtc::message_callback& send) {
+    auto now = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->send = send;
+        for (auto& message : messages) {
+            if (message->type != rtc::Message::Binary || message->size() < 12) continue;
+
+            uint8_t payload_type = get_byte(*message, 1) & 0x7F;
+            if (auto rtx_it = rtx_payload_types.find(payload_type); rtx_it != rtx_payload_types.end()) {
+                if (!restore_rtx(*message, rtx_it->second)) {
+                    message.reset();
+                    continue;
+                }
+                stats.rtx_packets++;
+            } else if (!is_media_payload_type(payload_type)) {
+                continue;
+            }
+
+            uint16_t seq = get_uint16(*message, 2);
+            if (!have_media_ssrc) {
+                media_ssrc = get_uint32(*message, 8);
+                highest_seq = seq;
+                have_media_ssrc = true;
+            } else {
+                on_packet(seq, now);
+            }
+        }
+    }
+
+    messages.erase(std::remove(messages.begin(), messages.end(), nullptr), messages.end());
+}
+
+NackStats NackRequester::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+TwccFeedbackGenerator::TwccFeedbackGenerator(uint8_t extension_id, uint32_t local_ssrc):
+    extension_id(extension_id),
+    local_ssrc(local_ssrc) {
+    timer = std::make_unique<RtcpTimer>(TWCC_FEEDBACK_INTERVAL, [this]() {
+        send_feedback();
+    });
+}
+
+std::optional<uint16_t> TwccFeedbackGenerator::find_sequence(const rtc::binary& packet) const {
+    if (!(get_byte(packet, 0) & 0x10)) return std::nullopt;
+
+    size_t offset = 12 + 4 * (get_byte(packet, 0) & 0x0F);
+    if (packet.size() < offset + 4) return std::nullopt;
+    uint16_t profile = get_uint16(packet, offset);
+    size_t begin = offset + 4;
+    size_t end = begin + 4 * get_uint16(packet, offset + 2);
+    if (packet.size() < end) return std::nullopt;
+
+    if (profile == 0xBEDE) {
+        // One-byte header extensions
+        for (size_t i = begin; i < end;) {
+            uint8_t header = get_byte(packet, i);
+            if (header == 0) {
+                ++i; // Padding
+                continue;
+            }
+
+            uint8_t id = header >> 4;
+            size_t size = (header & 0x0F) + 1;
+            if (id == 15) break;
+            if (id == extension_id && size >= 2 && i + 1 + size <= end) {
+                return get_uint16(packet, i + 1);
+            }
+            i += 1 + size;
+        }
+    } else if ((profile & 0xFFF0) == 0x1000) {
+        // Two-byte header extensions
+        for (size_t i = begin; i + 1 < end;) {
+            uint8_t id = get_byte(packet, i);
+            if (id == 0) {
+                ++i; // Padding
+                continue;
+            }
+
+            size_t size = get_byte(packet, i + 1);
+            if (id == extension_id && size >= 2 && i + 2 + size <= end) {
+                return get_uint16(packet, i + 2);
+            }
+            i += 2 + size;
+        }
+    }
+    return std::nullopt;
+}
+
+rtc::binary TwccFeedbackGenerator::build_feedback() {
+    // Packets that arrive after their sequence number was already reported as lost can't be reported again
+    arrivals.erase(arrivals.begin(), arrivals.lower_bound(next_report_sequence));
+    if (arrivals.empty()) return {};
+
+    int64_t base_sequence = std::max(next_report_sequence, arrivals.rbegin()->first - TWCC_MAX_STATUS_COUNT + 1);
+    int64_t last_sequence = arrivals.rbegin()->first;
+    arrivals.erase(arrivals.begin(), arrivals.lower_bound(base_sequence));
+
+    // The reference time is in multiples of 64 ms, and each delta is in multiples of 250 us from the previous arrival
+    int64_t reference_time = arrivals.begin()->second / 64000;
+    int64_t previous_arrival = reference_time * 64000;
+
+    std::vector<uint8_t> symbols;
+    rtc::binary deltas;
+    for (int64_t sequence = base_sequence; sequence <= last_sequence; ++sequence) {
+        auto arrival_it = arrivals.find(sequence);
+        if (arrival_it == arrivals.end()) {
+            symbols.push_back(0); // Not received
+            continue;
+        }
+
+        int64_t delta = std::clamp<int64_t>((arrival_it->second - previous_arrival) / 250, INT16_MIN, INT16_MAX);
+        if (delta >= 0 && delta <= 255) {
+            symbols.push_back(1); // Small delta
+            deltas.push_back((std::byte) delta);
+        } else {
+            symbols.push_back(2); // Large or negative delta
+            deltas.push_back((std::byte) ((uint16_t) delta >> 8));
+            deltas.push_back((std::byte) delta);
+        }
+        previous_arrival += delta * 250;
+        stats.packets_reported++;
+    }
+
+    // Two-bit status vector chunks hold seven packets each
+    size_t chunk_count = (symbols.size() + 6) / 7;
+    size_t size = 20 + 2 * chunk_count + deltas.size();
+    size_t padding = (4 - size % 4) % 4;
+
+    rtc::binary feedback(size + padding);
+    feedback[0] = (std::byte) (0x80 | (padding ? 0x20 : 0) | 15); // Version 2, FMT 15 (transport-wide feedback)
+    feedback[1] = (std::byte) 205;                                // Transport layer feedback
+    put_uint16(feedback, 2, feedback.size() / 4 - 1);
+    put_uint32(feedback, 4, local_ssrc);
+    put_uint32(feedback, 8, media_ssrc);
+    put_uint16(feedback, 12, base_sequence);
+    put_uint16(feedback, 14, symbols.size());
+    put_uint32(feedback, 16, (uint32_t) (reference_time & 0xFFFFFF) << 8 | feedback_count++);
+    for (size_t i = 0; i < chunk_count; ++i) {
+        uint16_t chunk = 0xC000;
+        for (size_t j = 0; j < 7 && i * 7 + j < symbols.size(); ++j) {
+            chunk |= symbols[i * 7 + j] << (2 * (6 - j));
+        }
+        put_uint16(feedback, 20 + 2 * i, chunk);
+    }
+    std::copy(deltas.begin(), deltas.end(), feedback.begin() + 20 + 2 * chunk_count);
+    if (padding) {
+        feedback.back() = (std::byte) padding;
+    }
+
+    arrivals.clear();
+    next_report_sequence = last_sequence + 1;
+    stats.feedback_sent++;
+    return feedback;
+}
+
+void TwccFeedbackGenerator::send_feedback() {
+    rtc::binary feedback;
+    rtc::message_callback send;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (arrivals.empty() || !this->send) return;
+        feedback = build_feedback();
+        send = this->send;
+    }
+
+    if (!feedback.empty()) {
+        send(rtc::make_message(std::move(feedback), rtc::Message::Control));
+    }
+}
+
+void TwccFeedbackGenerator::incoming(rtc::message_vector& messages, const rtc::message_callback& send) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->send = send;
+    for (const auto& message : messages) {
+        if (message->type != rtc::Message::Binary || message->size() < 12) continue;
+
+        std::optional<uint16_t> sequence = find_sequence(*message);
+        if (!sequence) continue;
+
+        // Each packet is stamped when it is handled, rather than the whole batch at the time it was handed over
+        int64_t arrival = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        int64_t unwrapped_sequence;
+        if (!have_sequence) {
+            media_ssrc = get_uint32(*message, 8);
+            unwrapped_sequence = last_sequence = next_report_sequence = *sequence;
+            have_sequence = true;
+        } else {
+            unwrapped_sequence = last_sequence + (int16_t) (*sequence - (uint16_t) last_sequence);
+            last_sequence = std::max(last_sequence, unwrapped_sequence);
+        }
+        if (unwrapped_sequence >= next_report_sequence) {
+            arrivals.emplace(unwrapped_sequence, arrival);
+        }
+    }
+}
+
+TwccStats TwccFeedbackGenerator::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void SenderReportObserver::incoming(rtc::message_vector& messages, const rtc::message_callback& send) {
+    for (const auto& message : messages) {
+        if (!message || message->type != rtc::Message::Control) continue;
+
+        // Reports are usually compound packets, so every packet in the message is checked
+        for (size_t offset = 0; offset + 4 <= message->size();) {
+            size_t size = 4 * (get_uint16(*message, offset + 2) + 1);
+            if (get_byte(*message, offset + 1) == 200 && offset + 20 <= message->size()) {
+                uint64_t ntp_timestamp = ((uint64_t) get_uint32(*message, offset + 8) << 32) | get_uint32(*message, offset + 12);
+                on_sender_report(get_uint32(*message, offset + 16), ntp_timestamp);
+            }
+            offset += size;
+        }
+    }
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <rtc/rtc.hpp>
+#include <stdint.h>
+#include <thread>
+#include <utility>
+
+struct NackStats {
+    uint64_t nacks_sent = 0;
+    uint64_t packets_requested = 0;
+    uint64_t packets_recovered = 0; // Arrived late or through RTX after being requested
+    uint64_t packets_abandoned = 0; // Never arrived despite every retry
+    uint64_t rtx_packets = 0;
+    double rtt = 0.; // Estimated from how long recoveries take, in milliseconds
+};
+
+struct KeyframeStats {
+    uint64_t requests_sent = 0;
+    uint64_t requests_suppressed = 0;
+};
+
+// Rate-limits automatic keyframe requests
+// Every request sent without a keyframe arriving in between doubles the interval before the next one may be sent
+class KeyframeRequester {
+protected:
+    std::function<void()> send_request;
+
+    mutable std::mutex mutex;
+    std::chrono::steady_clock::time_point last_request;
+    std::chrono::milliseconds interval;
+    KeyframeStats stats;
+
+public:
+    KeyframeRequester(std::function<void()> send_request);
+
+    // Used when the connection is replaced, whose sender hasn't been asked for a keyframe yet
+    void set_send_request(std::function<void()> send_request);
+
+    // Returns true if a request was actually sent
+    bool request();
+    void on_keyframe();
+
+    KeyframeStats get_stats() const;
+};
+
+// Calls a function at a fixed interval on its own thread until it is destroyed
+// Media handlers only run when packets arrive, so feedback that must go out on time is sent from one of these
+class RtcpTimer {
+protected:
+    std::chrono::milliseconds interval;
+    std::function<void()> callback;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopped = false;
+    std::thread thread;
+
+    void run();
+
+public:
+    RtcpTimer(std::chrono::milliseconds interval, std::function<void()> callback);
+    RtcpTimer(const RtcpTimer&) = delete;
+    RtcpTimer(RtcpTimer&&) = delete;
+
+    RtcpTimer& operator=(const RtcpTimer&) = delete;
+    RtcpTimer& operator=(RtcpTimer&&) = delete;
+
+    ~RtcpTimer();
+};
+
+// Detects sequence number gaps in the incoming RTP stream and requests the missing packets with generic NACKs (RFC 4585)
+// Retransmissions sent in an RTX stream (RFC 4588) are turned back into packets of the original stream
+class NackRequester : public rtc::MediaHandler {
+protected:
+    struct MissingPacket {
+        std::chrono::steady_clock::time_point detected;
+        std::chrono::steady_clock::time_point last_request;
+        unsigned int requests = 0;
+    };
+
+    std::map<uint8_t, uint8_t> rtx_payload_types; // Maps each RTX payload type to the one it retransmits
+    uint32_t local_ssrc;
+
+    mutable std::mutex mutex;
+    rtc::message_callback send; // From the last incoming packets, since requests are sent from the timer
+    bool have_media_ssrc = false;
+    uint32_t media_ssrc = 0;
+    uint16_t highest_seq = 0;
+    std::map<uint16_t, MissingPacket> missing;
+    NackStats stats;
+    std::shared_ptr<KeyframeRequester> keyframe_requester;
+    std::unique_ptr<RtcpTimer> timer; // Last, so that it stops before anything it uses is destroyed
+
+    bool restore_rtx(rtc::binary& packet, uint8_t payload_type);
+    bool is_media_payload_type(uint8_t payload_type) const;
+    void on_packet(uint16_t seq, std::chrono::steady_clock::time_point now);
+    void send_requests(std::chrono::steady_clock::time_point now);
+
+public:
+    // All payload types must share one sequence number space, like a codec and its RED encapsulation do
+    // Requests are sent from the local SSRC, and retried on a timer whether or not packets keep arriving
+    NackRequester(std::map<uint8_t, uint8_t> rtx_payload_types, uint32_t local_ssrc);
+    NackRequester(const NackRequester&) = delete;
+    NackRequester(NackRequester&&) = delete;
+
+    NackRequester& operator=(const NackRequester&) = delete;
+    NackRequester& operator=(NackRequester&&) = delete;
+
+    // Packets that can't be recovered will then ask for a keyframe instead
+    void set_keyframe_requester(std::shared_ptr<KeyframeRequester> keyframe_requester);
+
+    void incoming(rtc::message_vector& messages, const rtc::message_callback& send) override;
+
+    NackStats get_stats() const;
+};
+
+struct TwccStats {
+    uint64_t feedback_sent = 0;
+    uint64_t packets_reported = 0;
+};
+
+// Reports the arrival time of every packet carrying a transport-wide sequence number back to the sender
+// (draft-holmer-rmcat-transport-wide-cc-extensions-01), which lets the sender run delay-based congestion control
+class TwccFeedbackGenerator : public rtc::MediaHandler {
+protected:
+    uint8_t extension_id;
+    uint32_t local_ssrc;
+
+    mutable std::mutex mutex;
+    rtc::message_callback send; // From the last incoming packets, since feedback is sent from the timer
+    uint32_t media_ssrc = 0;
+    bool have_sequence = false;
+    int64_t last_sequence = 0;           // Unwrapped
+    int64_t next_report_sequence = 0;    // Unwrapped
+    std::map<int64_t, int64_t> arrivals; // Unwrapped transport-wide sequence number to arrival time in microseconds
+    uint8_t feedback_count = 0;
+    TwccStats stats;
+    std::unique_ptr<RtcpTimer> timer; // Last, so that it stops before anything it uses is destroyed
+
+    std::optional<uint16_t> find_sequence(const rtc::binary& packet) const;
+    rtc::binary build_feedback();
+    void send_feedback();
+
+public:
+    // Feedback is sent from the local SSRC at a fixed interval, so the sender sees a steady cadence regardless of how packets arrive
+    TwccFeedbackGenerator(uint8_t extension_id, uint32_t local_ssrc);
+    TwccFeedbackGenerator(const TwccFeedbackGenerator&) = delete;
+    TwccFeedbackGenerator(TwccFeedbackGenerator&&) = delete;
+
+    TwccFeedbackGenerator& operator=(const TwccFeedbackGenerator&) = delete;
+    TwccFeedbackGenerator& operator=(TwccFeedbackGenerator&&) = delete;
+
+    void incoming(rtc::message_vector& messages, const rtc::message_callback& send) override;
+
+    TwccStats get_stats() const;
+};
+
+// Passes the RTP and NTP timestamps from each RTCP sender report to a callback, without consuming the report
+class SenderReportObserver : public rtc::MediaHandler {
+protected:
+    std::function<void(uint32_t rtp_timestamp, uint64_t ntp_timestamp)> on_sender_report;
+
+public:
+    SenderReportObserver(std::function<void(uint32_t rtp_timestamp, uint64_t ntp_timestamp)> on_sender_report):
+        on_sender_report(std::move(on_sender_report)) {}
+
+    void incoming(rtc::message_vector& messages, const rtc::message_callback& send) override;
+};
@@ -0,0 +1,474 @@
+// clang-format off
+#include "Polyweb/polyweb.hpp"
+// clang-format on
+#include "signaling.hpp"
+#include "json.hpp"
+#include <algorithm>
+#include <ctype.h>
+#include <iostream>
+#include <map>
+#include <openssl/err.h>
+#include <optional>
+#include <thread>
+#include <utility>
+#ifdef _WIN32
+    #include <winsock2.h>
+#else
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/time.h>
+#endif
+
+#ifdef _WIN32
+using socket_t = SOCKET;
+#else
+using socket_t = int;
+#endif
+
+using nlohmann::json;
+
+constexpr std::chrono::seconds CANDIDATE_POLL_TIMEOUT(30);       // The server holds each poll open for less than this
+constexpr std::chrono::seconds MAX_IDLE_TIME(60);                // Servers close idle connections eventually, and a dead one costs a retry
+constexpr std::chrono::milliseconds SESSION_TICKET_TIMEOUT(500); // TLS 1.3 tickets follow the handshake by about a round trip
+constexpr size_t MAX_IDLE_CONNECTIONS = 4;
+
+static void set_socket_timeout(socket_t socket, std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+    DWORD value = timeout.count();
+#else
+    struct timeval value;
+    value.tv_sec = timeout.count() / 1000;
+    value.tv_usec = (timeout.count() % 1000) * 1000;
+#endif
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char*) &value, sizeof value);
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char*) &value, sizeof value);
+}
+
+static void set_socket_blocking(socket_t socket, bool blocking) {
+#ifdef _WIN32
+    u_long mode = !blocking;
+    ioctlsocket(socket, FIONBIO, &mode);
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    fcntl(socket, F_SETFL, blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK);
+#endif
+}
+
+// Unlike select, poll works with descriptors of any value
+static bool wait_readable(socket_t socket, std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+    WSAPOLLFD pfd = {socket, POLLRDNORM, 0};
+    return WSAPoll(&pfd, 1, timeout.count()) > 0;
+#else
+    struct pollfd pfd = {socket, POLLIN, 0};
+    return poll(&pfd, 1, timeout.count()) > 0;
+#endif
+}
+
+static bool contains_ignoring_case(const std::string& str, const std::string& token) {
+    return std::search(str.begin(), str.end(), token.begin(), token.end(), [](char a, char b) {
+        return tolower(a) == tolower(b);
+    }) != str.end();
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool SignalingCanceller::add_socket(uintptr_t socket) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (canceled) return false;
+    sockets.insert(socket);
+    return true;
+}
+
+void SignalingCanceller::remove_socket(uintptr_t socket) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sockets.erase(socket);
+}
+
+void SignalingCanceller::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    canceled = true;
+
+    // Shutting a socket down wakes up reads blocked on it, which closing it from another thread doesn't reliably do
+    // The sockets stay open until their requests notice, so their descriptors can't be reused in the meantime
+    for (uintptr_t socket : sockets) {
+#ifdef _WIN32
+        shutdown((socket_t) socket, SD_BOTH);
+#else
+        shutdown((socket_t) socket, SHUT_RDWR);
+#endif
+    }
+}
+
+struct SignalingClient::Connection {
+    pn::tcp::SecureClient client;
+    pn::tcp::BufReceiver buf_receiver; // Kept with the connection, since it may hold the start of the next response
+    std::chrono::steady_clock::time_point last_used = std::chrono::steady_clock::now();
+
+    socket_t socket() const {
+        return (socket_t) SSL_get_fd(client.ssl);
+    }
+
+    // Processes the TLS records that have arrived without blocking, waiting up to the timeout for the first of them
+    // Records that carry no data, like TLS 1.3 session tickets, make the socket readable too, so they can't be told apart from a closed connection without reading them
+    // Returns false if the server closed the connection or sent data that nothing asked for
+    bool drain(std::chrono::milliseconds timeout) {
+        while (wait_readable(socket(), timeout)) {
+            timeout = std::chrono::milliseconds(0);
+
+            set_socket_blocking(socket(), false);
+            ERR_clear_error();
+            char c;
+            int result = SSL_peek(client.ssl, &c, 1);
+            int error = SSL_get_error(client.ssl, result);
+            set_socket_blocking(socket(), true);
+
+            // Close notifications and EOF are reported as other errors
+            if (result > 0 || error != SSL_ERROR_WANT_READ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool is_alive() {
+        return std::chrono::steady_clock::now() - last_used < MAX_IDLE_TIME && drain(std::chrono::milliseconds(0));
+    }
+};
+
+SignalingClient::SignalingClient(std::string address, bool verify_certs):
+    address(std::move(address)),
+    verify_certs(verify_certs) {
+    // The address may carry a port, and IPv6 addresses are bracketed when it does
+    host = this->address;
+    port = "443";
+    if (!this->address.empty() && this->address.front() == '[') {
+        if (size_t end = this->address.find(']'); end != std::string::npos) {
+            host = this->address.substr(1, end - 1);
+            if (end + 1 < this->address.size() && this->address[end + 1] == ':') {
+                port = this->address.substr(end + 2);
+            }
+        }
+    } else if (size_t colon = this->address.find(':'); colon != std::string::npos && this->address.find(':', colon + 1) == std::string::npos) {
+        host = this->address.substr(0, colon);
+        port = this->address.substr(colon + 1);
+    }
+}
+
+SignalingClient::~SignalingClient() {
+    idle_connections.clear();
+    if (session) SSL_SESSION_free(session);
+}
+
+std::shared_ptr<SignalingClient> SignalingClient::get(const std::string& address, bool verify_certs) {
+    static std::mutex mutex;
+    static std::map<std::pair<std::string, bool>, std::shared_ptr<SignalingClient>> clients;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& client = clients[{address, verify_certs}];
+    if (!client) {
+        client = std::make_shared<SignalingClient>(address, verify_certs);
+    }
+    return client;
+}
+
+int SignalingClient::new_session_callback(SSL* ssl, SSL_SESSION* session) {
+    auto client = (SignalingClient*) SSL_get_app_data(ssl);
+    std::lock_guard<std::mutex> lock(client->mutex);
+    if (client->session) SSL_SESSION_free(client->session);
+    client->session = session;
+    return 1; // Takes ownership of the session
+}
+
+std::unique_ptr<SignalingClient::Connection> SignalingClient::take_idle_connection() {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!idle_connections.empty()) {
+        std::unique_ptr<Connection> connection = std::move(idle_connections.back());
+        idle_connections.pop_back();
+        if (connection->is_alive()) {
+            return connection;
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<SignalingClient::Connection> SignalingClient::connect(SignalingTiming& timing, std::string& error) {
+    auto connect_start = std::chrono::steady_clock::now();
+    auto connection = std::make_unique<Connection>();
+    if (auto result = connection->client.connect(host, port); !result) {
+        error = result.error().message();
+        return nullptr;
+    }
+
+    timing.connect_time = elapsed_ms(connect_start);
+
+    auto handshake_start = std::chrono::steady_clock::now();
+    if (auto result = connection->client.ssl_init(host, verify_certs ? SSL_VERIFY_PEER : SSL_VERIFY_NONE); !result) {
+        error = result.error().message();
+        return nullptr;
+    }
+    // Requests are small and sent in one write, so there is nothing to gain from delaying them
+    int no_delay = 1;
+    setsockopt(connection->socket(), IPPROTO_TCP, TCP_NODELAY, (const char*) &no_delay, sizeof no_delay);
+    set_socket_timeout(connection->socket(), std::chrono::seconds(5));
+
+    // Sessions are kept here rather than in OpenSSL's cache, which clients can't look up by server
+    // With TLS 1.3, tickets arrive after the handshake, so they are only seen through the callback
+    SSL_CTX* ctx = SSL_get_SSL_CTX(connection->client.ssl);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, new_session_callback);
+    SSL_set_app_data(connection->client.ssl, this);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (session && SSL_SESSION_is_resumable(session)) {
+            SSL_set_session(connection->client.ssl, session);
+        }
+    }
+
+    if (auto result = connection->client.ssl_connect(); !result) {
+        error = result.error().message();
+        return nullptr;
+    }
+    timing.handshake_time = elapsed_ms(handshake_start);
+    timing.resumed_session = SSL_session_reused(connection->client.ssl);
+    return connection;
+}
+
+void SignalingClient::release_connection(std::unique_ptr<Connection> connection) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idle_connections.size() < MAX_IDLE_CONNECTIONS) {
+        connection->last_used = std::chrono::steady_clock::now();
+        idle_connections.push_back(std::move(connection));
+    }
+}
+
+bool SignalingClient::send_request(Connection& connection, const std::vector<char>& request, SignalingResponse& resp, bool& sent, bool& keep_alive, std::string& error) {
+    // The request is written in one go, so a failed write means that none of it reached the server
+    ERR_clear_error();
+    if (SSL_write(connection.client.ssl, request.data(), (int) request.size()) <= 0) {
+        error = "Failed to send request";
+        return false;
+    }
+    sent = true;
+
+    pw::HTTPResponse http_resp;
+    if (auto result = http_resp.parse(connection.client, connection.buf_receiver); !result) {
+        error = result.error().message();
+        return false;
+    }
+    resp.status_code = http_resp.status_code;
+    resp.body = http_resp.body_string();
+
+    keep_alive = http_resp.http_version == "HTTP/1.1";
+    if (auto connection_it = http_resp.headers.find("Connection"); connection_it != http_resp.headers.end()) {
+        if (contains_ignoring_case(connection_it->second, "close")) {
+            keep_alive = false;
+        } else if (contains_ignoring_case(connection_it->second, "keep-alive")) {
+            keep_alive = true;
+        }
+    }
+
+    // Without a length, the body ended when the server closed the connection
+    if (!http_resp.headers.count("Content-Length") && !http_resp.headers.count("Transfer-Encoding")) {
+        keep_alive = false;
+    }
+    return true;
+}
+
+bool SignalingClient::post(const std::string& path, const std::string& body, SignalingResponse& resp, std::string& error, std::chrono::milliseconds timeout, SignalingCanceller* canceller) {
+    auto request_start = std::chrono::steady_clock::now();
+    pw::HTTPRequest req("POST",
+        path,
+        body,
+        {
+            {"Host", address},
+            {"Content-Type", "application/json"},
+            {"Content-Length", std::to_string(body.size())},
+            {"Connection", "keep-alive"},
+        });
+    std::vector<char> request = req.build();
+
+    // The server may close an idle connection just as it is reused, in which case the request is sent again on a new one
+    // That is only safe if the request was never written, since requests like /offer must not reach the server twice
+    for (bool retry = true;;) {
+        resp = {};
+        std::unique_ptr<Connection> connection;
+        if ((connection = take_idle_connection())) {
+            resp.timing.reused_connection = true;
+        } else if (!(connection = connect(resp.timing, error))) {
+            return false;
+        }
+        set_socket_timeout(connection->socket(), timeout);
+
+        // The socket is registered before anything is written, so that a cancellation can't be missed
+        if (canceller && !canceller->add_socket((uintptr_t) connection->socket())) {
+            error = "Request canceled";
+            return false;
+        }
+        bool sent = false;
+        bool keep_alive;
+        bool received = send_request(*connection, request, resp, sent, keep_alive, error);
+        if (canceller) {
+            canceller->remove_socket((uintptr_t) connection->socket());
+        }
+
+        if (!received) {
+            if (resp.timing.reused_connection && retry && !sent) {
+                retry = false;
+                continue;
+            }
+            return false;
+        }
+
+        if (keep_alive) {
+            release_connection(std::move(connection));
+        }
+        resp.timing.request_time = elapsed_ms(request_start);
+        return true;
+    }
+}
+
+void SignalingClient::warm_up() {
+    SignalingTiming timing;
+    std::string error;
+    if (auto connection = connect(timing, error)) {
+        // Reading the ticket now lets the next new connection resume the session, and keeps it from making this one look closed
+        if (SSL_version(connection->client.ssl) != TLS1_3_VERSION || connection->drain(SESSION_TICKET_TIMEOUT)) {
+            release_connection(std::move(connection));
+        }
+    } else {
+        std::cerr << "Error: Failed to warm up signaling connection: " << error << std::endl;
+    }
+}
+
+// Returns the parsed response body, or nullopt after printing why the request failed
+static std::optional<json> post_json(SignalingClient& client, const std::string& path, const json& req_json, std::chrono::milliseconds timeout, SignalingCanceller& canceller) {
+    SignalingResponse resp;
+    if (std::string error; !client.post(path, req_json.dump(), resp, error, timeout, &canceller)) {
+        std::cerr << "Error: Failed to exchange ICE candidates: " << error << std::endl;
+        return std::nullopt;
+    } else if (resp.status_code != 200) {
+        std::cerr << "Error: Failed to exchange ICE candidates: Response has status code " << resp.status_code << std::endl;
+        return std::nullopt;
+    }
+
+    try {
+        return resp.body.empty() ? json::object() : json::parse(resp.body);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Failed to parse ICE candidates: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+bool TrickleIce::is_stopped() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stopped;
+}
+
+void TrickleIce::send_local_candidates() {
+    for (;;) {
+        std::vector<rtc::Candidate> candidates;
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopped) return;
+            candidates = std::move(local_candidates);
+            local_candidates.clear();
+            done = gathering_complete;
+        }
+
+        if (!candidates.empty() || done) {
+            json candidates_json = json::array();
+            for (const auto& candidate : candidates) {
+                candidates_json.push_back({
+                    {"candidate", candidate.candidate()},
+                    {"sdpMid", candidate.mid()},
+                });
+            }
+
+            json req_json = {
+                {"password", password},
+                {"session", session},
+                {"candidates", candidates_json},
+                {"done", done},
+            };
+            if (!post_json(*client, "/candidate", req_json, std::chrono::seconds(5), canceller) || done) {
+                return;
+            }
+        }
+
+        // Candidates added since the queue was emptied leave the waiter notified
+        local_candidates_waiter.wait();
+    }
+}
+
+void TrickleIce::receive_remote_candidates() {
+    json req_json = {
+        {"password", password},
+        {"session", session},
+    };
+
+    while (!is_stopped()) {
+        // The server answers as soon as it has new candidates, or with none once the poll times out
+        std::optional<json> resp_json = post_json(*client, "/candidates", req_json, CANDIDATE_POLL_TIMEOUT, canceller);
+        if (!resp_json || is_stopped()) return;
+
+        auto conn = this->conn.lock();
+        if (!conn) return;
+
+        if (auto candidates_it = resp_json->find("candidates"); candidates_it != resp_json->end() && candidates_it->is_array()) {
+            for (const auto& candidate_json : *candidates_it) {
+                try {
+                    conn->addRemoteCandidate(rtc::Candidate(candidate_json["candidate"].get<std::string>(), candidate_json.value("sdpMid", std::string())));
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Failed to add remote ICE candidate: " << e.what() << std::endl;
+                }
+            }
+        }
+
+        if (auto done_it = resp_json->find("done"); done_it != resp_json->end() && done_it->is_boolean() && *done_it) {
+            return;
+        }
+    }
+}
+
+void TrickleIce::add_local_candidate(rtc::Candidate candidate) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        local_candidates.push_back(std::move(candidate));
+    }
+    local_candidates_waiter.notify_one();
+}
+
+void TrickleIce::complete_gathering() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        gathering_complete = true;
+    }
+    local_candidates_waiter.notify_one();
+}
+
+void TrickleIce::start(std::string session) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopped) return;
+        this->session = std::move(session);
+    }
+
+    std::thread(&TrickleIce::send_local_candidates, shared_from_this()).detach();
+    std::thread(&TrickleIce::receive_remote_candidates, shared_from_this()).detach();
+}
+
+void TrickleIce::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    local_candidates_waiter.notify_one();
+    canceller.cancel();
+}
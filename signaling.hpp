@@ -0,0 +1,129 @@
+#pragma once
+
+#include "util.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <openssl/ssl.h>
+#include <rtc/rtc.hpp>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// All durations are in milliseconds
+struct SignalingTiming {
+    bool reused_connection = false; // An idle connection was reused, so there was no handshake at all
+    bool resumed_session = false;   // A new connection resumed an earlier TLS session instead of doing a full handshake
+    double connect_time = 0.;       // DNS resolution and TCP connection
+    double handshake_time = 0.;
+    double request_time = 0.; // From the start of the request to the end of the response, including the above
+};
+
+struct SignalingResponse {
+    uint16_t status_code = 0;
+    std::string body;
+    SignalingTiming timing;
+};
+
+// Aborts requests from another thread by shutting down the sockets they are in flight on
+// Once canceled, every request made with the canceller fails immediately
+class SignalingCanceller {
+protected:
+    friend class SignalingClient;
+
+    std::mutex mutex;
+    bool canceled = false;
+    std::set<uintptr_t> sockets; // Wide enough for any platform's socket handles
+
+    bool add_socket(uintptr_t socket);
+    void remove_socket(uintptr_t socket);
+
+public:
+    void cancel();
+};
+
+// Sends HTTPS requests to one server over kept-alive HTTP/1.1 connections made with Polyweb, and resumes the last TLS session when a new connection is needed
+// Clients are shared by every window that connects to the same address with the same verification setting
+class SignalingClient {
+protected:
+    struct Connection;
+
+    std::string address;
+    std::string host;
+    std::string port;
+    bool verify_certs;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Connection>> idle_connections;
+    SSL_SESSION* session = nullptr;
+
+    static int new_session_callback(SSL* ssl, SSL_SESSION* session);
+
+    std::unique_ptr<Connection> take_idle_connection();
+    std::unique_ptr<Connection> connect(SignalingTiming& timing, std::string& error);
+    void release_connection(std::unique_ptr<Connection> connection);
+    bool send_request(Connection& connection, const std::vector<char>& request, SignalingResponse& resp, bool& sent, bool& keep_alive, std::string& error);
+
+public:
+    SignalingClient(std::string address, bool verify_certs);
+    SignalingClient(const SignalingClient&) = delete;
+    SignalingClient(SignalingClient&&) = delete;
+
+    SignalingClient& operator=(const SignalingClient&) = delete;
+    SignalingClient& operator=(SignalingClient&&) = delete;
+
+    ~SignalingClient();
+
+    static std::shared_ptr<SignalingClient> get(const std::string& address, bool verify_certs);
+
+    // Returns false and sets error if no response was received, regardless of its status code
+    // Blocks for up to the timeout, or until the canceller is canceled, so it must not be called from the main thread
+    bool post(const std::string& path, const std::string& body, SignalingResponse& resp, std::string& error, std::chrono::milliseconds timeout = std::chrono::seconds(5), SignalingCanceller* canceller = nullptr);
+
+    // Opens a connection and leaves it idle, so that the next request skips the resolution and handshakes
+    void warm_up();
+};
+
+// Exchanges ICE candidates with the server once the offer has been answered, so that the offer can be sent before gathering completes
+// Local candidates are queued until the server has assigned a session, then posted to /candidate in batches as they are gathered
+// Remote candidates are long-polled from /candidates and added to the connection until the server reports that it has no more
+class TrickleIce : public std::enable_shared_from_this<TrickleIce> {
+protected:
+    std::weak_ptr<rtc::PeerConnection> conn;
+    std::shared_ptr<SignalingClient> client;
+    std::string password;
+
+    std::mutex mutex;
+    std::string session;
+    std::vector<rtc::Candidate> local_candidates;
+    bool gathering_complete = false;
+    bool stopped = false;
+    Waiter local_candidates_waiter;
+    SignalingCanceller canceller; // Interrupts the long poll for remote candidates when stopped
+
+    bool is_stopped();
+    void send_local_candidates();
+    void receive_remote_candidates();
+
+public:
+    TrickleIce(std::weak_ptr<rtc::PeerConnection> conn, std::shared_ptr<SignalingClient> client, std::string password):
+        conn(std::move(conn)),
+        client(std::move(client)),
+        password(std::move(password)) {}
+    TrickleIce(const TrickleIce&) = delete;
+    TrickleIce(TrickleIce&&) = delete;
+
+    TrickleIce& operator=(const TrickleIce&) = delete;
+    TrickleIce& operator=(TrickleIce&&) = delete;
+
+    // Called from the connection's threads as gathering progresses
+    void add_local_candidate(rtc::Candidate candidate);
+    void complete_gathering();
+
+    // Must be called after the answer has been set as the remote description
+    // The exchange runs on its own threads, which keep this object alive until they notice that it has been stopped
+    void start(std::string session);
+    void stop();
+};
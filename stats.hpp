@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Counts events from any thread and turns them into a per-second rate when sampled
+class RateCounter {
+protected:
+    std::atomic<uint64_t> total = 0;
+
+    std::mutex mutex;
+    uint64_t last_total = 0;
+    std::chrono::steady_clock::time_point last_sample_time = std::chrono::steady_clock::now();
+    double last_rate = 0.;
+
+public:
+    void add(uint64_t amount = 1) {
+        total.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    uint64_t get_total() const {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    // The rate is recomputed at most once per second so that multiple readers see the same value
+    double rate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        if (double elapsed = std::chrono::duration<double>(now - last_sample_time).count(); elapsed >= 1.) {
+            uint64_t current_total = get_total();
+            last_rate = (current_total - last_total) / elapsed;
+            last_total = current_total;
+            last_sample_time = now;
+        }
+        return last_rate;
+    }
+};
+
+struct Percentiles {
+    double p50 = 0.;
+    double p95 = 0.;
+    double p99 = 0.;
+};
+
+// Keeps the most recent samples and computes percentiles over them on demand
+class RollingPercentiles {
+protected:
+    mutable std::mutex mutex;
+    std::vector<double> samples;
+    size_t capacity;
+    size_t next = 0;
+
+public:
+    RollingPercentiles(size_t capacity = 300):
+        capacity(capacity) {
+        samples.reserve(capacity);
+    }
+
+    void add(double sample) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (samples.size() < capacity) {
+            samples.push_back(sample);
+        } else {
+            samples[next] = sample;
+            next = (next + 1) % capacity;
+        }
+    }
+
+    Percentiles get() const {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::vector<double> sorted = samples;
+        lock.unlock();
+
+        Percentiles ret;
+        if (!sorted.empty()) {
+            std::sort(sorted.begin(), sorted.end());
+            ret.p50 = sorted[(sorted.size() - 1) * 50 / 100];
+            ret.p95 = sorted[(sorted.size() - 1) * 95 / 100];
+            ret.p99 = sorted[(sorted.size() - 1) * 99 / 100];
+        }
+        return ret;
+    }
+};
+
+// Records how long after the timer was created each phase of a process first completed, from any thread
+// Phases are numbered by an enum whose last member is Count
+template <typename Phase>
+class PhaseTimer {
+protected:
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    std::array<std::atomic<int64_t>, (size_t) Phase::Count> elapsed; // In microseconds, negative until the phase completes
+
+public:
+    PhaseTimer() {
+        for (auto& phase_elapsed : elapsed) {
+            phase_elapsed = -1;
+        }
+    }
+
+    // Later completions of the same phase, such as after a pipeline is rebuilt, are ignored
+    void mark(Phase phase) {
+        int64_t expected = -1;
+        int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+        elapsed[(size_t) phase].compare_exchange_strong(expected, now);
+    }
+
+    // In milliseconds, negative if the phase hasn't completed yet
+    double get(Phase phase) const {
+        int64_t phase_elapsed = elapsed[(size_t) phase];
+        return phase_elapsed < 0 ? -1. : phase_elapsed / 1000.;
+    }
+};
@@ -0,0 +1,174 @@
+#include "sync.hpp"
+#include "glib.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <gst/base/gstbasesink.h>
+
+constexpr double DELAY_SMOOTHING = 0.05;
+
+static uint64_t ntp_to_nanoseconds(uint64_t ntp_timestamp) {
+    return (ntp_timestamp >> 32) * GST_SECOND + (((ntp_timestamp & 0xFFFFFFFF) * GST_SECOND) >> 32);
+}
+
+void AvSync::on_sender_report(Stream& stream, uint32_t rtp_timestamp, uint64_t ntp_timestamp) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stream.have_sender_report = true;
+    stream.sender_report_rtp_timestamp = rtp_timestamp;
+    stream.sender_report_ntp_time = ntp_to_nanoseconds(ntp_timestamp);
+}
+
+void AvSync::on_jitterbuffer_output(Stream& stream, GstBuffer* buf) {
+    uint8_t header[8];
+    if (gst_buffer_extract(buf, 0, header, sizeof header) != sizeof header) return;
+    uint32_t rtp_timestamp = ((uint32_t) header[4] << 24) | ((uint32_t) header[5] << 16) | ((uint32_t) header[6] << 8) | header[7];
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Every packet of a video frame has the same timestamps, so only the first one is recorded
+    auto& last = stream.rtp_timestamps[(stream.next_rtp_timestamp + stream.rtp_timestamps.size() - 1) % stream.rtp_timestamps.size()];
+    if (last.first != GST_BUFFER_PTS(buf) || last.second != rtp_timestamp) {
+        if (GST_CLOCK_TIME_IS_VALID(last.first) && GST_BUFFER_PTS_IS_VALID(buf) && GST_BUFFER_PTS(buf) > last.first) {
+            stream.packet_duration = GST_BUFFER_PTS(buf) - last.first;
+        }
+        stream.rtp_timestamps[stream.next_rtp_timestamp] = {GST_BUFFER_PTS(buf), rtp_timestamp};
+        stream.next_rtp_timestamp = (stream.next_rtp_timestamp + 1) % stream.rtp_timestamps.size();
+    }
+}
+
+void AvSync::on_sink_input(Stream& stream, GstPad* pad, GstBuffer* buf) {
+    if (!GST_BUFFER_PTS_IS_VALID(buf)) return;
+
+    glib::Object<GstElement> sink = gst_pad_get_parent_element(pad);
+    if (!sink) return;
+    glib::Object<GstClock> clock = gst_element_get_clock(sink.get());
+    if (!clock) return;
+    GstEvent* segment_event = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+    if (!segment_event) return;
+
+    const GstSegment* segment;
+    gst_event_parse_segment(segment_event, &segment);
+    GstClockTime running_time = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buf));
+    gst_event_unref(segment_event);
+
+    // A synchronized sink renders once the clock reaches the buffer's running time plus the pipeline latency and its offset,
+    // or immediately if that has already passed, while an unsynchronized one renders as soon as the buffer arrives
+    auto render_time = (int64_t) (gst_clock_get_time(clock.get()) - gst_element_get_base_time(sink.get()));
+    if (GST_CLOCK_TIME_IS_VALID(running_time) && gst_base_sink_get_sync(GST_BASE_SINK(sink.get()))) {
+        render_time = std::max<int64_t>(render_time, (int64_t) (running_time + gst_base_sink_get_latency(GST_BASE_SINK(sink.get()))) + gst_base_sink_get_ts_offset(GST_BASE_SINK(sink.get())));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!stream.have_sender_report) return;
+
+    // Decoders and resamplers may retimestamp buffers slightly, so the nearest recorded timestamp is used if it's within half a packet
+    const std::pair<GstClockTime, uint32_t>* nearest = nullptr;
+    GstClockTime nearest_distance = GST_CLOCK_TIME_NONE;
+    for (const auto& entry : stream.rtp_timestamps) {
+        if (!GST_CLOCK_TIME_IS_VALID(entry.first)) continue;
+        auto distance = (GstClockTime) std::abs(GST_CLOCK_DIFF(entry.first, GST_BUFFER_PTS(buf)));
+        if (distance < nearest_distance) {
+            nearest = &entry;
+            nearest_distance = distance;
+        }
+    }
+    if (!nearest || nearest_distance * 2 > stream.packet_duration) return;
+
+    // The RTP timestamp is extrapolated from the last sender report, which may be slightly ahead of or behind it
+    // The difference between the matched and actual presentation timestamps is carried over to the capture time
+    auto capture_time = (int64_t) stream.sender_report_ntp_time + (int32_t) (nearest->second - stream.sender_report_rtp_timestamp) * (int64_t) GST_SECOND / stream.clock_rate + GST_CLOCK_DIFF(nearest->first, GST_BUFFER_PTS(buf));
+    double delay = render_time - capture_time;
+    if (stream.have_delay) {
+        stream.delay += (delay - stream.delay) * DELAY_SMOOTHING;
+    } else {
+        stream.delay = delay;
+        stream.have_delay = true;
+    }
+}
+
+void AvSync::attach(Stream& stream, GstElement* jitterbuffer, GstElement* sink) {
+    struct ProbeData {
+        AvSync* sync;
+        Stream* stream;
+    };
+
+    if (!jitterbuffer || !sink) return;
+
+    glib::Object<GstPad> jitterbuffer_pad = gst_element_get_static_pad(jitterbuffer, "src");
+    gst_pad_add_probe(jitterbuffer_pad.get(), GST_PAD_PROBE_TYPE_BUFFER, [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+        auto probe_data = (ProbeData*) data;
+        probe_data->sync->on_jitterbuffer_output(*probe_data->stream, GST_PAD_PROBE_INFO_BUFFER(info));
+        return GST_PAD_PROBE_OK;
+    },
+        new ProbeData {this, &stream},
+        [](void* data) {
+            delete (ProbeData*) data;
+        });
+
+    glib::Object<GstPad> sink_pad = gst_element_get_static_pad(sink, "sink");
+    gst_pad_add_probe(sink_pad.get(), GST_PAD_PROBE_TYPE_BUFFER, [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+        auto probe_data = (ProbeData*) data;
+        probe_data->sync->on_sink_input(*probe_data->stream, pad, GST_PAD_PROBE_INFO_BUFFER(info));
+        return GST_PAD_PROBE_OK;
+    },
+        new ProbeData {this, &stream},
+        [](void* data) {
+            delete (ProbeData*) data;
+        });
+}
+
+void AvSync::on_audio_sender_report(uint32_t rtp_timestamp, uint64_t ntp_timestamp) {
+    on_sender_report(audio, rtp_timestamp, ntp_timestamp);
+}
+
+void AvSync::on_video_sender_report(uint32_t rtp_timestamp, uint64_t ntp_timestamp) {
+    on_sender_report(video, rtp_timestamp, ntp_timestamp);
+}
+
+void AvSync::attach_audio(GstElement* jitterbuffer, GstElement* sink) {
+    attach(audio, jitterbuffer, sink);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    audio_sink = sink;
+    audio_offset = 0;
+}
+
+void AvSync::attach_video(GstElement* jitterbuffer, GstElement* sink) {
+    attach(video, jitterbuffer, sink);
+
+    // A rebuilt pipeline starts from scratch, so measurements from the old one no longer apply
+    std::lock_guard<std::mutex> lock(mutex);
+    video.reset_rtp_timestamps();
+    video.have_delay = false;
+}
+
+void AvSync::update() {
+    gint64 offset;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!audio_sink || !audio.have_delay || !video.have_delay) return;
+
+        double skew = audio.delay - video.delay;
+        if (std::abs(skew) <= max_skew) return;
+
+        // Changing the offset is heard as a gap or overlap, so it only happens once the skew is out of bounds
+        offset = std::max<gint64>(audio_offset - (gint64) skew, 0);
+        if (offset == audio_offset) return;
+
+        // The smoothed delay would otherwise take a while to reflect the new offset and trigger another correction
+        audio.delay += offset - audio_offset;
+        audio_offset = offset;
+    }
+    g_object_set(audio_sink, "ts-offset", offset, nullptr);
+}
+
+SyncStats AvSync::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    SyncStats ret;
+    ret.synchronized = audio.have_delay && video.have_delay;
+    if (ret.synchronized) {
+        ret.skew = (audio.delay - video.delay) / GST_MSECOND;
+    }
+    ret.audio_offset = (double) audio_offset / GST_MSECOND;
+    return ret;
+}
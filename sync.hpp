@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <gst/gst.h>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+// All durations are in milliseconds
+struct SyncStats {
+    bool synchronized = false; // Sender reports and rendered buffers have been seen for both streams
+    double skew = 0.;          // Positive if audio is rendered later than the video captured at the same time
+    double audio_offset = 0.;  // Delay currently added to the audio sink
+};
+
+// Measures how long after capture each stream is rendered, using the sender's RTCP sender reports to map RTP timestamps
+// to a common NTP timeline, and delays audio to match video when the two drift apart by more than the allowed skew
+// Video is never held back, so audio that lags behind video is only brought back as far as its own latency allows
+// Both pipelines must share a clock and base time so that their running times are comparable
+class AvSync {
+protected:
+    struct Stream {
+        unsigned int clock_rate;
+
+        bool have_sender_report = false;
+        uint32_t sender_report_rtp_timestamp = 0;
+        uint64_t sender_report_ntp_time = 0; // In nanoseconds
+
+        // Written at the jitter buffer output, where buffers still carry their RTP header
+        std::array<std::pair<GstClockTime, uint32_t>, 64> rtp_timestamps;
+        size_t next_rtp_timestamp = 0;
+        GstClockTime packet_duration = 0; // Between the last two recorded timestamps, or zero if unknown
+
+        bool have_delay = false;
+        double delay = 0.; // Smoothed render running time minus capture time, in nanoseconds
+
+        Stream(unsigned int clock_rate):
+            clock_rate(clock_rate) {
+            reset_rtp_timestamps();
+        }
+
+        void reset_rtp_timestamps() {
+            rtp_timestamps.fill({GST_CLOCK_TIME_NONE, 0});
+            next_rtp_timestamp = 0;
+            packet_duration = 0;
+        }
+    };
+
+    mutable std::mutex mutex;
+    Stream audio;
+    Stream video;
+    GstElement* audio_sink = nullptr;
+    GstClockTime max_skew;
+    gint64 audio_offset = 0;
+
+    void on_sender_report(Stream& stream, uint32_t rtp_timestamp, uint64_t ntp_timestamp);
+    void on_jitterbuffer_output(Stream& stream, GstBuffer* buf);
+    void on_sink_input(Stream& stream, GstPad* pad, GstBuffer* buf);
+    void attach(Stream& stream, GstElement* jitterbuffer, GstElement* sink);
+
+public:
+    AvSync(unsigned int audio_clock_rate, unsigned int video_clock_rate, GstClockTime max_skew):
+        audio(audio_clock_rate),
+        video(video_clock_rate),
+        max_skew(max_skew) {}
+    AvSync(const AvSync&) = delete;
+    AvSync(AvSync&&) = delete;
+
+    AvSync& operator=(const AvSync&) = delete;
+    AvSync& operator=(AvSync&&) = delete;
+
+    // Called from the track's receive thread with the timestamps from each sender report
+    void on_audio_sender_report(uint32_t rtp_timestamp, uint64_t ntp_timestamp);
+    void on_video_sender_report(uint32_t rtp_timestamp, uint64_t ntp_timestamp);
+
+    // The synchronizer must outlive the pipelines that these elements belong to
+    // The video pipeline may be attached again after it has been rebuilt
+    void attach_audio(GstElement* jitterbuffer, GstElement* sink);
+    void attach_video(GstElement* jitterbuffer, GstElement* sink);
+
+    // Called periodically from the main thread to adjust the audio sink's offset
+    void update();
+
+    SyncStats stats() const;
+};
@@ -5,6 +5,7 @@
 #include <FL/Fl_Box.H>
 #include <FL/fl_callback_macros.H>
 #include <FL/fl_message.H>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <stdio.h>
@@ -16,26 +17,6 @@
 
 using nlohmann::json;
 
-std::filesystem::path get_config_path() {
-    std::filesystem::path ret;
-#ifdef _WIN32
-    if (char* appdata = getenv("APPDATA")) {
-        ret = std::filesystem::path(appdata) / "lux-desktop";
-    }
-#elif defined(__APPLE__)
-    if (char* home = getenv("HOME")) {
-        ret = std::filesystem::path(home) / "Library" / "Application Support" / "lux-desktop";
-    }
-#else
-    if (char* xdg_config_home = getenv("XDG_CONFIG_HOME")) {
-        ret = std::filesystem::path(xdg_config_home) / "lux-desktop";
-    } else if (char* home = getenv("HOME")) {
-        ret = std::filesystem::path(home) / ".config" / "lux-desktop";
-    }
-#endif
-    return ret;
-}
-
 static int hex_value(char c) {
     if (c >= '0' && c <= '9') return c - '0';
     if (c >= 'a' && c <= 'f') return c - 'a' + 10;
@@ -135,58 +116,271 @@ ConnectionEditor::ConnectionEditor(int x, int y, int width, int height, const st
     Fl_Flex(x, y, width, height, Fl_Flex::COLUMN) {
     gap(5);
 
-    {
-        auto row = new Fl_Flex(Fl_Flex::ROW);
-        auto label = new Label(0, 0, "Name: ");
-        name_input = new Fl_Input(0, 0, 0, 0);
-        name_input->value(name.c_str());
-        row->fixed(label, label->w());
-        row->end();
-    }
+    tabs = new Fl_Tabs(x, y, width, height);
 
     {
-        auto row = new Fl_Flex(Fl_Flex::ROW);
-        auto label = new Label(0, 0, "Address: ");
-        address_input = new Fl_Input(0, 0, 0, 0);
-        address_input->value(conn_info.address.c_str());
-        row->fixed(label, label->w());
-        row->end();
-    }
+        auto tab = new Fl_Flex(x, y + 25, width, height - 25, Fl_Flex::COLUMN);
+        tab->label("General");
+        tab->margin(10);
+        tab->gap(5);
+
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Name: ");
+            name_input = new Fl_Input(0, 0, 0, 0);
+            name_input->value(name.c_str());
+            row->fixed(label, label->w());
+            row->end();
+        }
 
-    {
-        auto row = new Fl_Flex(Fl_Flex::ROW);
-        auto label = new Label(0, 0, "Password: ");
-        password_input = new Fl_Secret_Input(0, 0, 0, 0);
-        password_input->value(conn_info.password.c_str());
-        row->fixed(label, label->w());
-        row->end();
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Address: ");
+            address_input = new Fl_Input(0, 0, 0, 0);
+            address_input->value(conn_info.address.c_str());
+            row->fixed(label, label->w());
+            row->end();
+        }
+
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Password: ");
+            password_input = new Fl_Secret_Input(0, 0, 0, 0);
+            password_input->value(conn_info.password.c_str());
+            row->fixed(label, label->w());
+            row->end();
+        }
+
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Bitrate: ");
+            bitrate_spinner = new Fl_Spinner(0, 0, 0, 0);
+            bitrate_spinner->type(FL_INT_INPUT);
+            bitrate_spinner->minimum(500);
+            bitrate_spinner->maximum(10000);
+            bitrate_spinner->value(conn_info.bitrate);
+            row->fixed(label, label->w());
+            row->fixed(bitrate_spinner, 80);
+            row->end();
+        }
+
+        client_side_mouse_check_button = new Fl_Check_Button(0, 0, 0, 0, "Client-side mouse");
+        client_side_mouse_check_button->value(conn_info.client_side_mouse);
+
+        view_only_check_button = new Fl_Check_Button(0, 0, 0, 0, "View only");
+        view_only_check_button->value(conn_info.view_only);
+
+        verify_certs_check_button = new Fl_Check_Button(0, 0, 0, 0, "Verify certificates");
+        verify_certs_check_button->value(conn_info.verify_certs);
+
+        trickle_ice_check_button = new Fl_Check_Button(0, 0, 0, 0, "Trickle ICE candidates");
+        trickle_ice_check_button->value(conn_info.trickle_ice);
+        trickle_ice_check_button->tooltip("Connects without waiting for candidate gathering to complete, if the server supports it");
+
+        prepare_on_select_check_button = new Fl_Check_Button(0, 0, 0, 0, "Prepare when selected");
+        prepare_on_select_check_button->value(conn_info.prepare_on_select);
+        prepare_on_select_check_button->tooltip("Starts setting up the connection as soon as it is selected, so that connecting takes less time");
+
+        tab->end();
     }
 
     {
-        auto row = new Fl_Flex(Fl_Flex::ROW);
-        auto label = new Label(0, 0, "Bitrate: ");
-        bitrate_spinner = new Fl_Spinner(0, 0, 0, 0);
-        bitrate_spinner->type(FL_INT_INPUT);
-        bitrate_spinner->minimum(500);
-        bitrate_spinner->maximum(10000);
-        bitrate_spinner->value(conn_info.bitrate);
-        row->fixed(label, label->w());
-        row->fixed(bitrate_spinner, 80);
-        row->end();
-    }
+        auto tab = new Fl_Flex(x, y + 25, width, height - 25, Fl_Flex::COLUMN);
+        tab->label("Performance");
+        tab->margin(10);
+        tab->gap(5);
+
+        adaptive_bitrate_check_button = new Fl_Check_Button(0, 0, 0, 0, "Adaptive bitrate");
+        adaptive_bitrate_check_button->value(conn_info.adaptive_bitrate);
+
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Minimum bitrate: ");
+            min_bitrate_spinner = new Fl_Spinner(0, 0, 0, 0);
+            min_bitrate_spinner->type(FL_INT_INPUT);
+            min_bitrate_spinner->minimum(500);
+            min_bitrate_spinner->maximum(10000);
+            min_bitrate_spinner->value(conn_info.min_bitrate);
+            row->fixed(label, label->w());
+            row->fixed(min_bitrate_spinner, 80);
+            row->end();
+        }
+
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Maximum bitrate: ");
+            max_bitrate_spinner = new Fl_Spinner(0, 0, 0, 0);
+            max_bitrate_spinner->type(FL_INT_INPUT);
+            max_bitrate_spinner->minimum(500);
+            max_bitrate_spinner->maximum(10000);
+            max_bitrate_spinner->value(conn_info.max_bitrate);
+            row->fixed(label, label->w());
+            row->fixed(max_bitrate_spinner, 80);
+            row->end();
+        }
+
+        {
+            std::string video_codecs;
+            for (VideoCodec codec : conn_info.video_codecs) {
+                if (!video_codecs.empty()) video_codecs += ", ";
+                video_codecs += video_codec_name(codec);
+            }
+
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Video codecs: ");
+            video_codecs_input = new Fl_Input(0, 0, 0, 0);
+            video_codecs_input->value(video_codecs.c_str());
+            video_codecs_input->tooltip("Codecs to offer in order of preference, separated by commas (h264, h265, av1, vp9)");
+            row->fixed(label, label->w());
+            row->end();
+        }
+
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Decoder profile: ");
+            decoder_profile_choice = new Fl_Choice(0, 0, 0, 0);
+            decoder_profile_choice->add("Automatic");
+            decoder_profile_choice->add("Low latency");
+            decoder_profile_choice->add("Throughput");
+            decoder_profile_choice->value((int) conn_info.decoder_profile);
+            row->fixed(label, label->w());
+            row->end();
+        }
+
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Decoder threads: ");
+            decoder_threads_spinner = new Fl_Spinner(0, 0, 0, 0);
+            decoder_threads_spinner->type(FL_INT_INPUT);
+            decoder_threads_spinner->minimum(0);
+            decoder_threads_spinner->maximum(64);
+            decoder_threads_spinner->value(conn_info.decoder_threads);
+            decoder_threads_spinner->tooltip("0 lets the decoder decide");
+            row->fixed(label, label->w());
+            row->fixed(decoder_threads_spinner, 80);
+            row->end();
+        }
 
-    client_side_mouse_check_button = new Fl_Check_Button(0, 0, 0, 0, "Client-side mouse");
-    client_side_mouse_check_button->value(conn_info.client_side_mouse);
+        {
+            std::string decoders;
+            for (const auto& decoder : conn_info.decoders) {
+                if (!decoders.empty()) decoders += ", ";
+                decoders += decoder;
+            }
 
-    view_only_check_button = new Fl_Check_Button(0, 0, 0, 0, "View only");
-    view_only_check_button->value(conn_info.view_only);
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Decoders: ");
+            decoders_input = new Fl_Input(0, 0, 0, 0);
+            decoders_input->value(decoders.c_str());
+            decoders_input->tooltip("GStreamer decoder elements to try in order, separated by commas");
+            row->fixed(label, label->w());
+            row->end();
+        }
 
-    verify_certs_check_button = new Fl_Check_Button(0, 0, 0, 0, "Verify certificates");
-    verify_certs_check_button->value(conn_info.verify_certs);
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Latency profile: ");
+            latency_profile_choice = new Fl_Choice(0, 0, 0, 0);
+            latency_profile_choice->add("Competitive");
+            latency_profile_choice->add("Balanced");
+            latency_profile_choice->add("Smooth");
+            latency_profile_choice->value((int) conn_info.latency_profile);
+            row->fixed(label, label->w());
+            row->end();
+        }
 
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "Maximum A/V skew: ");
+            max_av_skew_spinner = new Fl_Spinner(0, 0, 0, 0);
+            max_av_skew_spinner->type(FL_INT_INPUT);
+            max_av_skew_spinner->minimum(10);
+            max_av_skew_spinner->maximum(500);
+            max_av_skew_spinner->value(conn_info.max_av_skew);
+            max_av_skew_spinner->tooltip("In milliseconds, audio is delayed to match video once they drift further apart");
+            row->fixed(label, label->w());
+            row->fixed(max_av_skew_spinner, 80);
+            row->end();
+        }
+
+        {
+            auto row = new Fl_Flex(Fl_Flex::ROW);
+            auto label = new Label(0, 0, "On corruption: ");
+            error_concealment_choice = new Fl_Choice(0, 0, 0, 0);
+            error_concealment_choice->add("Show corrupt frames");
+            error_concealment_choice->add("Freeze on last good frame");
+            error_concealment_choice->value((int) conn_info.error_concealment);
+            row->fixed(label, label->w());
+            row->end();
+        }
+
+        direct_rendering_check_button = new Fl_Check_Button(0, 0, 0, 0, "Decode directly into video buffers");
+        direct_rendering_check_button->value(conn_info.direct_rendering);
+
+        fec_check_button = new Fl_Check_Button(0, 0, 0, 0, "Forward error correction");
+        fec_check_button->value(conn_info.fec);
+
+        tab->hide();
+        tab->end();
+    }
+
+    tabs->end();
     end();
 }
 
+// Splits a comma-separated list, trimming spaces and skipping empty items
+static std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> ret;
+    for (size_t begin = 0, end; begin < list.size(); begin = end + 1) {
+        if ((end = list.find(',', begin)) == std::string::npos) {
+            end = list.size();
+        }
+
+        size_t first = list.find_first_not_of(' ', begin);
+        size_t last = list.find_last_not_of(' ', end - 1);
+        if (first < end && last != std::string::npos && last >= first) {
+            ret.push_back(list.substr(first, last - first + 1));
+        }
+    }
+    return ret;
+}
+
+ConnectionInfo ConnectionEditor::to_conn_info() const {
+    ConnectionInfo ret(address_input->value(),
+        password_input->value(),
+        (unsigned int) bitrate_spinner->value(),
+        (bool) client_side_mouse_check_button->value(),
+        (bool) view_only_check_button->value(),
+        (bool) verify_certs_check_button->value());
+    ret.trickle_ice = trickle_ice_check_button->value();
+    ret.prepare_on_select = prepare_on_select_check_button->value();
+    ret.adaptive_bitrate = adaptive_bitrate_check_button->value();
+    ret.min_bitrate = min_bitrate_spinner->value();
+    ret.max_bitrate = max_bitrate_spinner->value();
+    // Choices report -1 without a selection, which falls back to their first item
+    ret.decoder_profile = (DecoderProfile) std::max(decoder_profile_choice->value(), 0);
+    ret.decoder_threads = decoder_threads_spinner->value();
+    ret.direct_rendering = direct_rendering_check_button->value();
+    ret.latency_profile = (LatencyProfile) std::max(latency_profile_choice->value(), 0);
+    ret.error_concealment = (ErrorConcealment) std::max(error_concealment_choice->value(), 0);
+    ret.max_av_skew = max_av_skew_spinner->value();
+    ret.fec = fec_check_button->value();
+
+    ret.decoders = split_list(decoders_input->value());
+
+    std::vector<VideoCodec> video_codecs;
+    for (const auto& name : split_list(video_codecs_input->value())) {
+        if (auto codec = parse_video_codec(name); codec && std::find(video_codecs.begin(), video_codecs.end(), *codec) == video_codecs.end()) {
+            video_codecs.push_back(*codec);
+        }
+    }
+    if (!video_codecs.empty()) {
+        ret.video_codecs = std::move(video_codecs);
+    }
+
+    return ret;
+}
+
 MainWindow::MainWindow():
     Fl_Double_Window(1100, 650, "Lux Client") {
     xclass("lux-desktop");
@@ -225,6 +419,31 @@ MainWindow::MainWindow():
         window->handle_toggle_fullscreen();
     },
         this);
+    menu_bar->add("View/Toggle Statistics", FL_F + 12, [](Fl_Widget*, void* data) {
+        auto window = (MainWindow*) data;
+        if (window->video_window && window->video_window->is_playing()) {
+            window->video_window->toggle_statistics();
+        }
+    },
+        this);
+    menu_bar->add("View/Latency Profile/Competitive", 0, [](Fl_Widget*, void* data) {
+        auto window = (MainWindow*) data;
+        window->handle_set_latency_profile(LatencyProfile::Competitive);
+    },
+        this,
+        FL_MENU_RADIO);
+    menu_bar->add("View/Latency Profile/Balanced", 0, [](Fl_Widget*, void* data) {
+        auto window = (MainWindow*) data;
+        window->handle_set_latency_profile(LatencyProfile::Balanced);
+    },
+        this,
+        FL_MENU_RADIO);
+    menu_bar->add("View/Latency Profile/Smooth", 0, [](Fl_Widget*, void* data) {
+        auto window = (MainWindow*) data;
+        window->handle_set_latency_profile(LatencyProfile::Smooth);
+    },
+        this,
+        FL_MENU_RADIO);
     menu_bar->add("View/Set Bitrate", 0, [](Fl_Widget*, void* data) {
         auto window = (MainWindow*) data;
         window->handle_set_bitrate();
@@ -255,7 +474,7 @@ MainWindow::MainWindow():
     stage = new Stage(200, menu_bar->h(), 900, h() - menu_bar->h(), "Select a connection to begin.");
     stage->box(FL_DOWN_BOX);
     stage->end();
-    tile->size_range(stage, 370, 295);
+    tile->size_range(stage, 370, 500);
     tile->resizable(stage);
 
     tile->end();
@@ -305,19 +524,23 @@ void MainWindow::refresh() {
 }
 
 void MainWindow::handle_select_conn() {
-    Fl::remove_timeout(check_ice_state, this);
+    Fl::remove_timeout(handle_stream_end, this);
+    Fl::remove_timeout(expire_prepared_conn, this);
+    prepared_conn.reset();
     stage->set_centered(nullptr);
     stage->set_fill(false);
     delete conn_editor;
     delete video_window;
     conn_editor = nullptr;
     video_window = nullptr;
+    update_latency_profile_menu();
 
     if (conn_list->value()) {
         copy_label((std::string(conn_list->text(conn_list->value())).substr(2) + " - Lux Client").c_str());
         stage->begin();
 
-        conn_editor = new ConnectionEditor(0, 0, 350, 275, std::string(conn_list->text(conn_list->value())).substr(2), *(ConnectionInfo*) conn_list->data(conn_list->value()));
+        auto conn_info = (ConnectionInfo*) conn_list->data(conn_list->value());
+        conn_editor = new ConnectionEditor(0, 0, 350, 480, std::string(conn_list->text(conn_list->value())).substr(2), *conn_info);
         conn_editor->begin();
 
         auto row = new Fl_Flex(Fl_Flex::ROW);
@@ -376,7 +599,12 @@ void MainWindow::handle_select_conn() {
         connect_button->selection_color(fl_rgb_color(0, 86, 179));
         connect_button->labelcolor(FL_WHITE);
         FL_INLINE_CALLBACK_2(connect_button, MainWindow*, window, this, int, index, conn_list->value(), {
-            window->video_window = new VideoWindow(0, 0, 400, 400, window->conn_editor->to_conn_info());
+            Fl::remove_timeout(expire_prepared_conn, window);
+            window->video_window = new VideoWindow(0, 0, 400, 400, window->conn_editor->to_conn_info(), std::move(window->prepared_conn));
+            window->video_window->stream_end_cb = [window]() {
+                // Deferred, since the video window can't be deleted from within its own callback
+                Fl::add_timeout(0.0, handle_stream_end, window);
+            };
 
             window->stage->set_centered(nullptr);
             delete window->conn_editor;
@@ -390,22 +618,30 @@ void MainWindow::handle_select_conn() {
                 window->handle_select_conn();
                 return;
             }
-            Fl::add_timeout(1.0, check_ice_state, window);
+            window->update_latency_profile_menu();
         });
         row->fixed(connect_button, connect_button->w());
 
         row->end();
+        conn_editor->fixed(row, 30);
         conn_editor->end();
         stage->set_centered(conn_editor);
         stage->end();
+
+        // Discarded when another entry is selected, or once it's too old to be taken over
+        if (conn_info->prepare_on_select) {
+            prepared_conn = std::make_unique<PreparedConnection>(*conn_info);
+            prepared_conn->warm_up_signaling();
+            Fl::add_timeout(PREPARED_CONNECTION_TTL, expire_prepared_conn, this);
+        }
     } else {
         label("Lux Client");
     }
 }
 
 void MainWindow::handle_new_conn() {
-    auto window = new Fl_Double_Window(370, 295, "New Connection");
-    window->size_range(350, 295, 0, 400);
+    auto window = new Fl_Double_Window(370, 500, "New Connection");
+    window->size_range(350, 500, 0, 600);
     window->set_modal();
 
     auto conn_editor = new ConnectionEditor(10, 10, window->w() - 20, window->h() - 55);
@@ -490,6 +726,32 @@ void MainWindow::handle_download() {
     }
 }
 
+void MainWindow::handle_set_latency_profile(LatencyProfile latency_profile) {
+    if (video_window && video_window->is_playing()) {
+        video_window->set_latency_profile(latency_profile);
+    }
+    update_latency_profile_menu();
+}
+
+void MainWindow::update_latency_profile_menu() {
+    const char* paths[] = {
+        "View/Latency Profile/Competitive",
+        "View/Latency Profile/Balanced",
+        "View/Latency Profile/Smooth",
+    };
+
+    // Without a session, no profile is selected
+    for (size_t i = 0; i < sizeof paths / sizeof paths[0]; ++i) {
+        if (auto item = (Fl_Menu_Item*) menu_bar->find_item(paths[i])) {
+            if (video_window && video_window->is_playing() && (size_t) video_window->get_latency_profile() == i) {
+                item->set();
+            } else {
+                item->clear();
+            }
+        }
+    }
+}
+
 void MainWindow::handle_set_bitrate() {
     if (video_window && video_window->is_connected()) {
         auto window = new Fl_Double_Window(250, 85, "Set Bitrate");
@@ -556,21 +818,18 @@ void MainWindow::handle_toggle_fullscreen() {
     }
 }
 
-void MainWindow::check_ice_state(void* data) {
+void MainWindow::handle_stream_end(void* data) {
     auto window = (MainWindow*) data;
+    if (!window->video_window) return;
 
-    if (window->video_window->has_connection_error()) {
-        window->handle_select_conn();
-        return;
-    }
-
-    if (auto ice_state = window->video_window->ice_state();
-        ice_state == rtc::PeerConnection::IceState::Closed ||
-        ice_state == rtc::PeerConnection::IceState::Failed) {
+    // Errors have already been shown by the video window
+    if (!window->video_window->has_connection_error()) {
         fl_message("The connection has closed.");
-        window->handle_select_conn();
-        return;
     }
+    window->handle_select_conn();
+}
 
-    Fl::repeat_timeout(1.0, check_ice_state, data);
+void MainWindow::expire_prepared_conn(void* data) {
+    auto window = (MainWindow*) data;
+    window->prepared_conn.reset();
 }
@@ -4,6 +4,7 @@
 #include "video.hpp"
 #include <FL/Fl.H>
 #include <FL/Fl_Check_Button.H>
+#include <FL/Fl_Choice.H>
 #include <FL/Fl_Double_Window.H>
 #include <FL/Fl_Flex.H>
 #include <FL/Fl_Hold_Browser.H>
@@ -11,6 +12,7 @@
 #include <FL/Fl_Menu_Bar.H>
 #include <FL/Fl_Secret_Input.H>
 #include <FL/Fl_Spinner.H>
+#include <FL/Fl_Tabs.H>
 #include <FL/Fl_Tile.H>
 #include <memory>
 #include <string>
@@ -21,6 +23,7 @@ inline bool is_key_global_shortcut(int key) {
     case FL_F + 5:
     case FL_F + 9:
     case FL_F + 11:
+    case FL_F + 12:
         return true;
 
     default:
@@ -57,6 +60,7 @@ public:
 
 class ConnectionEditor : public Fl_Flex {
 protected:
+    Fl_Tabs* tabs;
     Fl_Input* name_input;
     Fl_Input* address_input;
     Fl_Secret_Input* password_input;
@@ -64,6 +68,20 @@ protected:
     Fl_Check_Button* client_side_mouse_check_button;
     Fl_Check_Button* view_only_check_button;
     Fl_Check_Button* verify_certs_check_button;
+    Fl_Check_Button* trickle_ice_check_button;
+    Fl_Check_Button* prepare_on_select_check_button;
+    Fl_Check_Button* adaptive_bitrate_check_button;
+    Fl_Spinner* min_bitrate_spinner;
+    Fl_Spinner* max_bitrate_spinner;
+    Fl_Input* video_codecs_input;
+    Fl_Choice* decoder_profile_choice;
+    Fl_Spinner* decoder_threads_spinner;
+    Fl_Input* decoders_input;
+    Fl_Check_Button* direct_rendering_check_button;
+    Fl_Choice* latency_profile_choice;
+    Fl_Spinner* max_av_skew_spinner;
+    Fl_Choice* error_concealment_choice;
+    Fl_Check_Button* fec_check_button;
 
 public:
     ConnectionEditor(int x, int y, int width, int height, const std::string& name = {}, const ConnectionInfo& connection = {}, bool show_connect_button = false);
@@ -72,16 +90,7 @@ public:
         return name_input->value();
     }
 
-    ConnectionInfo to_conn_info() const {
-        return {
-            address_input->value(),
-            password_input->value(),
-            (unsigned int) bitrate_spinner->value(),
-            (bool) client_side_mouse_check_button->value(),
-            (bool) view_only_check_button->value(),
-            (bool) verify_certs_check_button->value(),
-        };
-    }
+    ConnectionInfo to_conn_info() const;
 };
 
 class MainWindow : public Fl_Double_Window {
@@ -105,6 +114,7 @@ protected:
     Stage* stage;
     ConnectionEditor* conn_editor = nullptr;
     VideoWindow* video_window = nullptr;
+    std::unique_ptr<PreparedConnection> prepared_conn;
 
     std::vector<std::unique_ptr<ConnectionInfo>> connections;
 
@@ -113,7 +123,10 @@ protected:
     void handle_new_conn();
     void handle_upload();
     void handle_download();
+    void handle_set_latency_profile(LatencyProfile latency_profile);
+    void update_latency_profile_menu();
     void handle_set_bitrate();
     void handle_toggle_fullscreen();
-    static void check_ice_state(void* data);
+    static void handle_stream_end(void* data);
+    static void expire_prepared_conn(void* data);
 };
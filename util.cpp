@@ -1,5 +1,26 @@
 #include "util.hpp"
+#include <stdlib.h>
 
 namespace detail {
     std::thread::id main_thread_id = std::this_thread::get_id();
 }
+
+std::filesystem::path get_config_path() {
+    std::filesystem::path ret;
+#ifdef _WIN32
+    if (char* appdata = getenv("APPDATA")) {
+        ret = std::filesystem::path(appdata) / "lux-desktop";
+    }
+#elif defined(__APPLE__)
+    if (char* home = getenv("HOME")) {
+        ret = std::filesystem::path(home) / "Library" / "Application Support" / "lux-desktop";
+    }
+#else
+    if (char* xdg_config_home = getenv("XDG_CONFIG_HOME")) {
+        ret = std::filesystem::path(xdg_config_home) / "lux-desktop";
+    } else if (char* home = getenv("HOME")) {
+        ret = std::filesystem::path(home) / ".config" / "lux-desktop";
+    }
+#endif
+    return ret;
+}
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <chrono>
 #include <condition_variable>
+#include <filesystem>
 #include <mutex>
 #include <thread>
 #include <type_traits>
@@ -59,6 +60,9 @@ public:
     }
 };
 
+// Returns an empty path if the platform's configuration directory can't be determined
+std::filesystem::path get_config_path();
+
 namespace detail {
     extern std::thread::id main_thread_id;
 
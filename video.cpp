@@ -2,6 +2,8 @@
 #include "Polyweb/polyweb.hpp"
 // clang-format on
 #include "video.hpp"
+#include "certificate.hpp"
+#include "health.hpp"
 #include "json.hpp"
 #include "keys.hpp"
 #include "ui.hpp"
@@ -9,12 +11,423 @@
 #include <FL/fl_ask.H>
 #include <FL/fl_draw.H>
 #include <FL/x.H>
+#include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <gst/base/gstbasesink.h>
+#include <gst/video/gstvideopool.h>
+#include <gst/video/video.h>
 #include <gst/video/videooverlay.h>
+#include <initializer_list>
 #include <inttypes.h>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <stdio.h>
+#include <string>
+#include <variant>
+#include <vector>
 
 using nlohmann::json;
 
+constexpr double BITRATE_UPDATE_INTERVAL = 1.;
+constexpr double AUDIO_JITTERBUFFER_UPDATE_INTERVAL = 1.;
+constexpr double SYNC_UPDATE_INTERVAL = 0.5;
+constexpr double ICE_DISCONNECTED_GRACE = 1.; // In seconds, after which a disconnected connection is replaced instead of waiting for it to fail
+constexpr unsigned int MAX_RECONNECT_ATTEMPTS = 3;
+constexpr unsigned int STALL_FRAME_INTERVALS = 3;            // Media is silent once this many frames in a row are missing
+constexpr unsigned int STALL_AUDIO_PACKETS = 5;              // Or this many audio packets, whichever takes longer
+constexpr double DEFAULT_FRAME_RATE = 30.;                   // Assumed if the answer doesn't say
+constexpr double DEFAULT_AUDIO_PACKET_TIME = 20.;            // In milliseconds, and assumed if the answer doesn't say
+constexpr double DEGRADED_RTT = 250.;                        // In milliseconds
+constexpr unsigned int MAX_AUDIO_JITTERBUFFER_LATENCY = 200; // In milliseconds
+constexpr int VIDEO_RED_PAYLOAD_TYPE = 117;
+constexpr int VIDEO_ULPFEC_PAYLOAD_TYPE = 118;
+constexpr int VIDEO_RED_RTX_PAYLOAD_TYPE = 119;
+constexpr int VIDEO_TWCC_EXTENSION_ID = 3;
+
+#ifdef _WIN32
+constexpr const char* VIDEO_SINK = "d3d11videosink";
+constexpr const char* AUDIO_SINKS[] = {"wasapi2sink", "wasapisink", "directsoundsink"};
+#elif defined(__APPLE__)
+constexpr const char* VIDEO_SINK = "osxvideosink";
+constexpr const char* AUDIO_SINKS[] = {"osxaudiosink"};
+#else
+constexpr const char* VIDEO_SINK = "xvimagesink";
+constexpr const char* AUDIO_SINKS[] = {"pulsesink", "alsasink"};
+#endif
+
+struct LatencyProfileSettings {
+    unsigned int jitterbuffer_latency; // In milliseconds
+    const char* jitterbuffer_mode;
+    bool sync;
+    gint64 max_lateness; // -1 never drops late frames
+    GstClockTime max_queue_time;
+    unsigned int audio_jitterbuffer_latency; // Minimum, in milliseconds
+    gint64 audio_buffer_time;                // In microseconds
+    gint64 audio_latency_time;               // In microseconds
+};
+
+static LatencyProfileSettings get_latency_profile_settings(LatencyProfile profile) {
+    switch (profile) {
+    case LatencyProfile::Balanced:
+        return {40, "slave", true, 20 * GST_MSECOND, 200 * GST_MSECOND, 40, 60000, 10000};
+
+    case LatencyProfile::Smooth:
+        return {120, "slave", true, -1, 400 * GST_MSECOND, 80, 100000, 20000};
+
+    default:
+        return {0, "none", false, 0, 100 * GST_MSECOND, 20, 40000, 10000};
+    }
+}
+
+struct VideoCodecSettings {
+    const char* encoding_name; // As it appears in the SDP and the RTP caps
+    int payload_type;
+    int rtx_payload_type;
+    const char* depayloader;
+    const char* parser;
+    const char* caps;                  // Of the parsed stream
+    std::vector<std::string> decoders; // Platform defaults in order of preference
+};
+
+static VideoCodecSettings get_video_codec_settings(VideoCodec codec) {
+    switch (codec) {
+    case VideoCodec::H265:
+        return {"H265",
+            100,
+            101,
+            "rtph265depay",
+            "h265parse",
+            "video/x-h265",
+#ifdef _WIN32
+            {"d3d11h265dec", "avdec_h265"},
+#else
+            {"avdec_h265"},
+#endif
+        };
+
+    case VideoCodec::AV1:
+        return {"AV1",
+            102,
+            103,
+            "rtpav1depay",
+            "av1parse",
+            "video/x-av1",
+#ifdef _WIN32
+            {"d3d11av1dec", "dav1ddec", "av1dec"},
+#else
+            {"dav1ddec", "av1dec"},
+#endif
+        };
+
+    case VideoCodec::VP9:
+        return {"VP9",
+            104,
+            105,
+            "rtpvp9depay",
+            "vp9parse",
+            "video/x-vp9",
+#ifdef _WIN32
+            {"d3d11vp9dec", "avdec_vp9", "vp9dec"},
+#else
+            {"avdec_vp9", "vp9dec"},
+#endif
+        };
+
+    default:
+        return {"H264",
+            96,
+            99,
+            "rtph264depay",
+            "h264parse",
+            "video/x-h264",
+#ifdef _WIN32
+            {"d3d11h264dec", "avdec_h264"},
+#else
+            {"avdec_h264"},
+#endif
+        };
+    }
+}
+
+// Finds the codec of the first payload type that the answer accepted for video
+static std::optional<VideoCodec> get_answered_video_codec(rtc::Description& answer) {
+    for (unsigned int i = 0; i < (unsigned int) answer.mediaCount(); ++i) {
+        auto entry = answer.media(i);
+        auto media = std::get_if<rtc::Description::Media*>(&entry);
+        if (!media || (*media)->type() != "video") continue;
+
+        for (int payload_type : (*media)->payloadTypes()) {
+            std::string format = (*media)->rtpMap(payload_type)->format;
+            std::transform(format.begin(), format.end(), format.begin(), [](unsigned char c) {
+                return std::tolower(c);
+            });
+            if (auto codec = parse_video_codec(format)) {
+                return codec;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+// Finds the value of the first attribute with the name in the answer's media of the type
+static std::optional<double> get_answered_media_attribute(rtc::Description& answer, const std::string& type, const std::string& name) {
+    for (unsigned int i = 0; i < (unsigned int) answer.mediaCount(); ++i) {
+        auto entry = answer.media(i);
+        auto media = std::get_if<rtc::Description::Media*>(&entry);
+        if (!media || (*media)->type() != type) continue;
+
+        for (const auto& attribute : (*media)->attributes()) {
+            if (attribute.size() > name.size() && attribute.compare(0, name.size(), name) == 0 && attribute[name.size()] == ':') {
+                try {
+                    return std::stod(attribute.substr(name.size() + 1));
+                } catch (const std::exception&) {
+                    return std::nullopt;
+                }
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+// Media has stalled once it has been silent for longer than the sender would normally go without sending a frame or an audio packet
+static std::chrono::milliseconds get_stall_timeout(double frame_rate, double audio_packet_time) {
+    double frame_intervals = STALL_FRAME_INTERVALS * 1000. / frame_rate;
+    double audio_packets = STALL_AUDIO_PACKETS * audio_packet_time;
+    return std::chrono::milliseconds((long long) std::ceil(std::max(frame_intervals, audio_packets)));
+}
+
+// Tries the configured decoders and then the platform defaults, skipping any that can't decode the codec,
+// and applies the threading profile to the first one that exists
+static GstElement* make_video_decoder(const ConnectionInfo& conn_info, const VideoCodecSettings& codec_settings) {
+    std::vector<std::string> candidates = conn_info.decoders;
+    candidates.insert(candidates.end(), codec_settings.decoders.begin(), codec_settings.decoders.end());
+
+    GstCaps* caps = gst_caps_from_string(codec_settings.caps);
+    GstElement* decoder = nullptr;
+    for (const auto& candidate : candidates) {
+        glib::Object<GstElementFactory> factory = gst_element_factory_find(candidate.c_str());
+        if (factory && gst_element_factory_can_sink_any_caps(factory.get(), caps) && (decoder = gst_element_factory_create(factory.get(), nullptr))) {
+            break;
+        }
+    }
+    gst_caps_unref(caps);
+
+    if (!decoder) return nullptr;
+
+    GObjectClass* klass = G_OBJECT_GET_CLASS(decoder);
+    if (g_object_class_find_property(klass, "direct-rendering")) {
+        g_object_set(decoder, "direct-rendering", conn_info.direct_rendering, nullptr);
+    }
+    if (g_object_class_find_property(klass, "output-corrupt")) {
+        g_object_set(decoder, "output-corrupt", conn_info.error_concealment == ErrorConcealment::ShowCorrupt, nullptr);
+    }
+    if (g_object_class_find_property(klass, "discard-corrupted-frames")) {
+        g_object_set(decoder, "discard-corrupted-frames", conn_info.error_concealment == ErrorConcealment::FreezeOnLastGood, nullptr);
+    }
+    if (g_object_class_find_property(klass, "automatic-request-sync-points")) {
+        g_object_set(decoder, "automatic-request-sync-points", TRUE, nullptr);
+    }
+    if (conn_info.decoder_threads && g_object_class_find_property(klass, "max-threads")) {
+        g_object_set(decoder, "max-threads", (int) conn_info.decoder_threads, nullptr);
+    }
+    if (conn_info.decoder_threads && g_object_class_find_property(klass, "n-threads")) {
+        gst_util_set_object_arg(G_OBJECT(decoder), "n-threads", std::to_string(conn_info.decoder_threads).c_str());
+    }
+    if (g_object_class_find_property(klass, "threads")) {
+        // libvpx decodes on a single thread unless told otherwise, and accepts at most 16
+        unsigned int threads = std::min(conn_info.decoder_threads ? conn_info.decoder_threads : g_get_num_processors(), 16u);
+        gst_util_set_object_arg(G_OBJECT(decoder), "threads", std::to_string(threads).c_str());
+    }
+    if (conn_info.decoder_profile == DecoderProfile::LowLatency && g_object_class_find_property(klass, "max-frame-delay")) {
+        // dav1d otherwise holds frames back to decode several in parallel
+        gst_util_set_object_arg(G_OBJECT(decoder), "max-frame-delay", "1");
+    }
+    if (g_object_class_find_property(klass, "thread-type")) {
+        switch (conn_info.decoder_profile) {
+        case DecoderProfile::LowLatency:
+            gst_util_set_object_arg(G_OBJECT(decoder), "thread-type", "slice");
+            break;
+
+        case DecoderProfile::Throughput:
+            gst_util_set_object_arg(G_OBJECT(decoder), "thread-type", "frame");
+            break;
+
+        default:
+            break;
+        }
+    }
+    return decoder;
+}
+
+// Returns the platform's native audio sink so that its ring buffer can be sized, or nullptr if none is installed
+static GstElement* make_audio_sink() {
+    for (const char* candidate : AUDIO_SINKS) {
+        if (GstElement* sink = gst_element_factory_make(candidate, nullptr)) {
+            return sink;
+        }
+    }
+    return nullptr;
+}
+
+// Drops elements that were created but never added to a bin, which still hold their floating reference
+static void unref_floating_elements(std::initializer_list<GstElement*> elements) {
+    for (GstElement* element : elements) {
+        if (element) gst_object_unref(gst_object_ref_sink(element));
+    }
+}
+
+// Loads the plugin behind every element that the pipelines may be built from, for any of the offered codecs
+// Loading a plugin maps its library and initializes the codec libraries it links against, which is most of the cost of building a pipeline
+static void preload_plugins(const ConnectionInfo& conn_info) {
+    std::vector<std::string> names = {"appsrc", "rtpjitterbuffer", "queue", "textoverlay", VIDEO_SINK, "rtpopusdepay", "capsfilter", "opusdec", "audioconvert", "audioresample", "autoaudiosink"};
+    names.insert(names.end(), std::begin(AUDIO_SINKS), std::end(AUDIO_SINKS));
+    if (conn_info.fec) {
+        names.insert(names.end(), {"rtpreddec", "rtpstorage", "rtpulpfecdec"});
+    }
+    names.insert(names.end(), conn_info.decoders.begin(), conn_info.decoders.end());
+    for (VideoCodec codec : conn_info.video_codecs) {
+        VideoCodecSettings codec_settings = get_video_codec_settings(codec);
+        names.insert(names.end(), {codec_settings.depayloader, codec_settings.parser});
+        names.insert(names.end(), codec_settings.decoders.begin(), codec_settings.decoders.end());
+    }
+
+    for (const auto& name : names) {
+        if (glib::Object<GstElementFactory> factory = gst_element_factory_find(name.c_str())) {
+            glib::Object<GstPluginFeature> loaded = gst_plugin_feature_load(GST_PLUGIN_FEATURE(factory.get()));
+        }
+    }
+}
+
+// Sets the pipeline to PLAYING from GStreamer's thread pool, since opening devices and starting each element's threads can take a while
+// The phase, if any, is marked once the state change has been made
+static void start_pipeline(GstElement* pipeline, std::shared_ptr<PhaseTimer<StartupPhase>> startup_timer = nullptr, StartupPhase phase = StartupPhase::Count) {
+    struct StartData {
+        std::shared_ptr<PhaseTimer<StartupPhase>> startup_timer;
+        StartupPhase phase;
+    };
+
+    gst_element_call_async(pipeline, [](GstElement* pipeline, void* data) {
+        auto start_data = (StartData*) data;
+
+        // Checked under the state lock so that a pipeline stopped in the meantime stays stopped
+        GST_STATE_LOCK(pipeline);
+        bool stopped = g_object_get_data(G_OBJECT(pipeline), "lux-stopped");
+        if (!stopped) {
+            gst_element_set_state(pipeline, GST_STATE_PLAYING);
+        }
+        GST_STATE_UNLOCK(pipeline);
+
+        if (!stopped && start_data->startup_timer) {
+            start_data->startup_timer->mark(start_data->phase);
+        }
+    },
+        new StartData {std::move(startup_timer), phase},
+        [](void* data) {
+            delete (StartData*) data;
+        });
+}
+
+static void stop_pipeline(GstElement* pipeline) {
+    GST_STATE_LOCK(pipeline);
+    g_object_set_data(G_OBJECT(pipeline), "lux-stopped", GINT_TO_POINTER(TRUE));
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    GST_STATE_UNLOCK(pipeline);
+}
+
+PreparedConnection::PreparedConnection(ConnectionInfo conn_info):
+    conn_info(std::move(conn_info)) {
+    rtc::Configuration config;
+    config.iceServers.emplace_back("stun.l.google.com:19302");
+    config.enableIceTcp = true;
+    if (auto certificate = get_dtls_certificate()) {
+        // Loading a cached certificate is much faster than generating a key pair for every connection
+        config.certificatePemFile = certificate->certificate_path;
+        config.keyPemFile = certificate->key_path;
+    }
+    conn = std::make_shared<rtc::PeerConnection>(config);
+
+    {
+        // Codecs are offered in order of preference, and the pipeline is rebuilt if the answer picks another one
+        rtc::Description::Video video("video", rtc::Description::Direction::RecvOnly);
+        for (VideoCodec codec : this->conn_info.video_codecs) {
+            VideoCodecSettings codec_settings = get_video_codec_settings(codec);
+            switch (codec) {
+            case VideoCodec::H265:
+                video.addH265Codec(codec_settings.payload_type);
+                break;
+
+            case VideoCodec::AV1:
+                video.addAV1Codec(codec_settings.payload_type);
+                break;
+
+            case VideoCodec::VP9:
+                video.addVP9Codec(codec_settings.payload_type);
+                break;
+
+            default:
+                video.addH264Codec(codec_settings.payload_type);
+                break;
+            }
+            video.addRtxCodec(codec_settings.rtx_payload_type, codec_settings.payload_type, 90000);
+            video.rtpMap(codec_settings.payload_type)->addFeedback("transport-cc");
+            rtx_payload_types[codec_settings.rtx_payload_type] = codec_settings.payload_type;
+        }
+        video.addExtMap(rtc::Description::Entry::ExtMap(VIDEO_TWCC_EXTENSION_ID, "http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01"));
+        if (this->conn_info.fec) {
+            // FEC packets are carried in RED so that they share the media's sequence numbers
+            video.addVideoCodec(VIDEO_RED_PAYLOAD_TYPE, "red");
+            video.addVideoCodec(VIDEO_ULPFEC_PAYLOAD_TYPE, "ulpfec");
+            video.addRtxCodec(VIDEO_RED_RTX_PAYLOAD_TYPE, VIDEO_RED_PAYLOAD_TYPE, 90000);
+            video.rtpMap(VIDEO_RED_PAYLOAD_TYPE)->addFeedback("transport-cc");
+        }
+
+        // The track only receives, but its RTCP feedback still needs a sender SSRC of its own
+        std::random_device random_device;
+        video.addSSRC(std::uniform_int_distribution<uint32_t>(1)(random_device), "lux");
+        video_track = conn->addTrack(video);
+    }
+
+    {
+        rtc::Description::Audio audio("audio", rtc::Description::Direction::RecvOnly);
+        audio.addOpusCodec(97);
+        audio_track = conn->addTrack(audio);
+    }
+
+    // Channels must exist before the offer is created for it to include them
+    ordered_channel = conn->createDataChannel("ordered-input");
+    if (!this->conn_info.view_only) {
+        unordered_channel = conn->createDataChannel("unordered-input",
+            {
+                .reliability = {
+                    .unordered = true,
+                },
+            });
+    }
+    health_channel = conn->createDataChannel("health",
+        {
+            .reliability = {
+                .unordered = true,
+                .maxRetransmits = 0,
+            },
+        });
+
+    conn->setLocalDescription();
+}
+
+void PreparedConnection::warm_up_signaling() const {
+    std::thread([client = SignalingClient::get(conn_info.address, conn_info.verify_certs)]() {
+        client->warm_up();
+    }).detach();
+}
+
+bool PreparedConnection::is_reusable(const ConnectionInfo& conn_info) const {
+    return conn && std::chrono::steady_clock::now() - creation_time < std::chrono::duration<double>(PREPARED_CONNECTION_TTL) &&
+           conn->state() != rtc::PeerConnection::State::Closed && conn->state() != rtc::PeerConnection::State::Failed &&
+           this->conn_info.to_json() == conn_info.to_json();
+}
+
 int VideoWindow::system_event_handler(void* event, void* data) {
     auto window = (VideoWindow*) data;
     auto parsed_event = window->mouse_manager->parse_event(event);
@@ -38,73 +451,378 @@ void VideoWindow::loading_timer_callback(void* data) {
     }
 }
 
-VideoWindow::VideoWindow(int x, int y, int width, int height, ConnectionInfo conn_info):
+void VideoWindow::statistics_timer_callback(void* data) {
+    auto window = (VideoWindow*) data;
+    if (window->statistics_visible) {
+        VideoStatistics stats = window->get_statistics();
+        BusStats bus_stats = window->get_video_bus_stats();
+
+        char rtt[32] = "N/A";
+        if (stats.rtt >= 0.) {
+            snprintf(rtt, sizeof rtt, "%.0f ms", stats.rtt);
+        }
+
+        char av_skew[64] = "N/A";
+        if (SyncStats sync_stats = window->get_sync_stats(); sync_stats.synchronized) {
+            snprintf(av_skew, sizeof av_skew, "%.1f ms (audio delayed %.0f ms)", sync_stats.skew, sync_stats.audio_offset);
+        }
+
+        // Phases that haven't completed yet are left out
+        std::string startup;
+        const char* phase_names[] = {"plugins", "ICE", "answer", "pipeline", "track", "first frame"};
+        for (size_t i = 0; i < (size_t) StartupPhase::Count; ++i) {
+            if (double time = window->get_startup_time((StartupPhase) i); time >= 0.) {
+                char phase[32];
+                snprintf(phase, sizeof phase, "%s%s %.0f", startup.empty() ? "" : ", ", phase_names[i], time);
+                startup += phase;
+            }
+        }
+
+        char signaling[96] = "N/A";
+        if (SignalingTiming offer_timing = window->get_offer_timing(); offer_timing.request_time > 0.) {
+            if (offer_timing.reused_connection) {
+                snprintf(signaling, sizeof signaling, "%.0f ms (reused connection)", offer_timing.request_time);
+            } else {
+                snprintf(signaling, sizeof signaling, "%.0f ms (connect %.0f ms, TLS %.0f ms%s)", offer_timing.request_time, offer_timing.connect_time, offer_timing.handshake_time, offer_timing.resumed_session ? " resumed" : "");
+            }
+        }
+
+        char health[64];
+        if (HealthStats health_stats = window->get_health_stats(); health_stats.rtt >= 0.) {
+            snprintf(health, sizeof health, "%s (ping %.0f ms, %" PRIu64 " stalls)", health_state_name(health_stats.state), health_stats.rtt, health_stats.stalls);
+        } else {
+            snprintf(health, sizeof health, "%s (%" PRIu64 " stalls)", health_state_name(health_stats.state), health_stats.stalls);
+        }
+
+        const char* zero_copy = "No";
+        switch (stats.zero_copy) {
+        case ZeroCopyState::SinkPool:
+            zero_copy = "Yes (sink pool)";
+            break;
+
+        case ZeroCopyState::NegotiatedPool:
+            zero_copy = "Yes (negotiated pool)";
+            break;
+
+        default:
+            break;
+        }
+
+        const char* overlay = "Unknown";
+        switch (stats.overlay_composition) {
+        case OverlayCompositionState::Supported:
+            overlay = "Composited by sink";
+            break;
+
+        case OverlayCompositionState::Unsupported:
+            overlay = "Blended (copies frames)";
+            break;
+
+        default:
+            break;
+        }
+
+        char text[2048];
+        snprintf(text,
+            sizeof text,
+            "Codec: %s\n"
+            "Health: %s\n"
+            "Startup (ms): %s\n"
+            "Offer: %s\n"
+            "Received: %.1f fps\n"
+            "Decoded: %.1f fps (%.1f ms)\n"
+            "Dropped: %" PRIu64 " frames\n"
+            "Bitrate: %.0f / %u kbps\n"
+            "Jitter: %.1f ms\n"
+            "Loss: %" PRIu64 " packets (%.2f%%)\n"
+            "RTT: %s\n"
+            "Audio: %.1f ms (jitter buffer %u ms)\n"
+            "A/V skew: %s\n"
+            "Queue overruns: %" PRIu64 "\n"
+            "Packet pool: %" PRIu64 " hits, %" PRIu64 " misses (peak %u)\n"
+            "NACK: %" PRIu64 " sent, %" PRIu64 " recovered\n"
+            "FEC: %" PRIu64 " recovered, %" PRIu64 " unrecovered\n"
+            "Keyframe requests: %" PRIu64 "\n"
+            "TWCC: %" PRIu64 " feedback, %" PRIu64 " packets reported\n"
+            "QoS: %" PRIu64 " decoder drops, %" PRIu64 " late (max %.1f ms)\n"
+            "Errors: %" PRIu64 "\n"
+            "Zero-copy: %s\n"
+            "Overlay: %s",
+            get_video_codec_settings(window->video_codec).encoding_name,
+            health,
+            startup.c_str(),
+            signaling,
+            stats.received_fps,
+            stats.decoded_fps,
+            stats.decode_time,
+            stats.dropped_frames,
+            stats.bitrate,
+            stats.requested_bitrate,
+            stats.jitter,
+            stats.packets_lost,
+            stats.loss_rate * 100.,
+            rtt,
+            stats.audio_latency,
+            stats.audio_jitterbuffer_latency,
+            av_skew,
+            stats.queue_overruns,
+            stats.pool_hits,
+            stats.pool_misses,
+            stats.pool_high_water,
+            stats.nacks_sent,
+            stats.packets_recovered,
+            stats.fec_recovered,
+            stats.fec_unrecovered,
+            stats.keyframe_requests,
+            stats.twcc_feedback_sent,
+            stats.twcc_packets_reported,
+            bus_stats.decoder_drops,
+            bus_stats.sink_late_frames,
+            bus_stats.max_sink_lateness,
+            bus_stats.errors,
+            zero_copy,
+            overlay);
+        window->show_statistics(text);
+
+        Fl::repeat_timeout(0.5, statistics_timer_callback, data);
+    }
+}
+
+void VideoWindow::bitrate_timer_callback(void* data) {
+    auto window = (VideoWindow*) data;
+    if (window->video_track->isOpen()) {
+        VideoStatistics stats = window->get_statistics();
+        const VideoStatistics& last_stats = window->last_bitrate_statistics;
+
+        BitrateSample sample;
+        uint64_t received = stats.packets_received - std::min(stats.packets_received, last_stats.packets_received);
+        uint64_t lost = stats.packets_lost - std::min(stats.packets_lost, last_stats.packets_lost);
+        if (received + lost) {
+            sample.loss_rate = (double) lost / (received + lost);
+        }
+        sample.jitter = stats.jitter;
+        sample.late_frames = stats.dropped_frames - std::min(stats.dropped_frames, last_stats.dropped_frames);
+        sample.frames = stats.received_fps * BITRATE_UPDATE_INTERVAL;
+        if (window->video_latency_tracker) {
+            sample.one_way_delay = window->video_latency_tracker->take_one_way_delay();
+        }
+        sample.measured_bitrate = stats.bitrate;
+        window->last_bitrate_statistics = stats;
+
+        // Small adjustments aren't worth the encoder reconfiguration they cause
+        unsigned int bitrate = window->bitrate_controller.update(sample);
+        if (std::abs((double) bitrate - window->conn_info.bitrate) >= window->conn_info.bitrate * 0.02) {
+            window->video_track->requestBitrate((window->conn_info.bitrate = bitrate) * 1000);
+        }
+    }
+    Fl::repeat_timeout(BITRATE_UPDATE_INTERVAL, bitrate_timer_callback, data);
+}
+
+void VideoWindow::audio_jitterbuffer_timer_callback(void* data) {
+    auto window = (VideoWindow*) data;
+    if (window->audio_jitterbuffer) {
+        window->adapt_audio_jitterbuffer();
+    }
+    Fl::repeat_timeout(AUDIO_JITTERBUFFER_UPDATE_INTERVAL, audio_jitterbuffer_timer_callback, data);
+}
+
+void VideoWindow::sync_timer_callback(void* data) {
+    auto window = (VideoWindow*) data;
+    window->av_sync->update();
+    Fl::repeat_timeout(SYNC_UPDATE_INTERVAL, sync_timer_callback, data);
+}
+
+void VideoWindow::stall_timer_callback(void* data) {
+    auto window = (VideoWindow*) data;
+    if (window->conn->iceState() == rtc::PeerConnection::IceState::Disconnected) {
+        if (!window->reconnect()) {
+            window->end_stream();
+        }
+    }
+}
+
+VideoWindow::VideoWindow(int x, int y, int width, int height, ConnectionInfo conn_info, std::unique_ptr<PreparedConnection> prepared_conn):
     Fl_Double_Window(x, y, width, height),
-    conn_info(std::move(conn_info)) {
+    conn_info(std::move(conn_info)),
+    bitrate_controller(this->conn_info.bitrate, this->conn_info.min_bitrate, this->conn_info.max_bitrate) {
     resizable(this);
     end(); // No child widgets!
 
-    rtc::Configuration config;
-    config.iceServers.emplace_back("stun.l.google.com:19302");
-    config.enableIceTcp = true;
-    conn = std::make_shared<rtc::PeerConnection>(config);
+    // Both pipelines run from the same clock and base time, so running times in one can be compared with the other
+    pipeline_clock = gst_system_clock_obtain();
+    pipeline_base_time = gst_clock_get_time(pipeline_clock.get());
+    video_codec = this->conn_info.video_codecs.front();
+    startup_timer = std::make_shared<PhaseTimer<StartupPhase>>();
+    av_sync = std::make_shared<AvSync>(48000, 90000, this->conn_info.max_av_skew * GST_MSECOND);
+    health_monitor = std::make_shared<HealthMonitor>(get_stall_timeout(DEFAULT_FRAME_RATE, DEFAULT_AUDIO_PACKET_TIME), DEGRADED_RTT);
+
+    // The pipeline's probes hold on to this requester for the window's lifetime, and each connection only replaces how it sends requests
+    keyframe_requester = std::make_shared<KeyframeRequester>([]() {});
+
+    // The pipelines are built while ICE candidates are gathered and the offer is sent, so that showing the window only has to start them
+    // They are built for the preferred codec, and the video pipeline is rebuilt if the server answers with another one
+    pipeline_cancel_token = std::make_shared<std::atomic<bool>>(false);
+    pipeline_thread = std::thread([this, conn_info = this->conn_info, codec = video_codec, cancel_token = pipeline_cancel_token]() {
+        preload_plugins(conn_info);
+        startup_timer->mark(StartupPhase::PluginsLoaded);
+
+        std::string error;
+        std::unique_ptr<VideoPipeline> video;
+        std::unique_ptr<AudioPipeline> audio;
+        if (!*cancel_token && (video = build_video_pipeline(conn_info, codec, error))) {
+            audio = build_audio_pipeline(conn_info, error);
+        }
 
-    {
-        rtc::Description::Video video("video", rtc::Description::Direction::RecvOnly);
-        video.addH264Codec(96);
-        video_track = conn->addTrack(video);
+        awake([this, cancel_token, video = std::move(video), audio = std::move(audio), error = std::move(error)]() mutable {
+            if (*cancel_token) return;
+            if (!video || !audio) {
+                connection_error = true;
+                fl_alert("%s", error.c_str());
+                end_stream();
+                return;
+            }
+
+            pending_video_pipeline = std::move(video);
+            pending_audio_pipeline = std::move(audio);
+            if (shown()) {
+                start_pending_pipelines();
+            }
+        });
+    });
+
+    // A prepared connection has already been gathering candidates, possibly since before the user asked to connect
+    if (!prepared_conn || !prepared_conn->is_reusable(this->conn_info)) {
+        prepared_conn = std::make_unique<PreparedConnection>(this->conn_info);
     }
 
-    {
-        rtc::Description::Audio audio("audio", rtc::Description::Direction::RecvOnly);
-        audio.addOpusCodec(97);
-        audio_track = conn->addTrack(audio);
+    std::random_device random_device;
+    std::uniform_int_distribution<int> hex_digit(0, 15);
+    for (int i = 0; i < 32; ++i) {
+        stream_id.push_back("0123456789abcdef"[hex_digit(random_device)]);
     }
 
-    video_track->setMediaHandler(std::make_shared<rtc::RtcpReceivingSession>());
-    audio_track->setMediaHandler(std::make_shared<rtc::RtcpReceivingSession>());
+    attach_connection(std::move(prepared_conn));
+    file_manager = std::make_unique<FileManager>(ordered_channel);
+}
 
-    video_track->onOpen([this]() {
-        video_track->requestBitrate(this->conn_info.bitrate * 1000);
-    });
+void VideoWindow::attach_connection(std::unique_ptr<PreparedConnection> prepared_conn) {
+    conn = std::move(prepared_conn->conn);
+    video_track = std::move(prepared_conn->video_track);
+    audio_track = std::move(prepared_conn->audio_track);
+    ordered_channel = std::move(prepared_conn->ordered_channel);
+    unordered_channel = std::move(prepared_conn->unordered_channel);
+    health_channel = std::move(prepared_conn->health_channel);
+    std::map<uint8_t, uint8_t> rtx_payload_types = std::move(prepared_conn->rtx_payload_types);
+    prepared_conn.reset();
 
-    file_manager = std::make_unique<FileManager>(ordered_channel = conn->createDataChannel("ordered-input"));
-    if (!conn_info.view_only) {
-        unordered_channel = conn->createDataChannel("unordered-input",
-            {
-                .reliability = {
-                    .unordered = true,
-                },
-            });
+    {
+        std::vector<uint32_t> local_ssrcs = video_track->description().getSSRCs();
+        uint32_t local_ssrc = local_ssrcs.empty() ? 1 : local_ssrcs.front();
+
+        auto session = std::make_shared<rtc::RtcpReceivingSession>();
+        if (this->conn_info.fec) {
+            rtx_payload_types[VIDEO_RED_RTX_PAYLOAD_TYPE] = VIDEO_RED_PAYLOAD_TYPE;
+        }
+        session->addToChain(video_nack_requester = std::make_shared<NackRequester>(std::move(rtx_payload_types), local_ssrc));
+
+        keyframe_requester->set_send_request([video_track = std::weak_ptr<rtc::Track>(video_track)]() {
+            if (auto track = video_track.lock()) {
+                track->requestKeyframe();
+            }
+        });
+        video_nack_requester->set_keyframe_requester(keyframe_requester);
+
+        video_nack_requester->addToChain(std::make_shared<SenderReportObserver>([av_sync = av_sync](uint32_t rtp_timestamp, uint64_t ntp_timestamp) {
+            av_sync->on_video_sender_report(rtp_timestamp, ntp_timestamp);
+        }));
+
+        // Handlers added later see incoming packets first, so arrival times are taken before any other processing
+        video_nack_requester->addToChain(video_twcc_generator = std::make_shared<TwccFeedbackGenerator>(VIDEO_TWCC_EXTENSION_ID, local_ssrc));
+        video_track->setMediaHandler(session);
     }
+    {
+        auto session = std::make_shared<rtc::RtcpReceivingSession>();
+        session->addToChain(std::make_shared<SenderReportObserver>([av_sync = av_sync](uint32_t rtp_timestamp, uint64_t ntp_timestamp) {
+            av_sync->on_audio_sender_report(rtp_timestamp, ntp_timestamp);
+        }));
+        audio_track->setMediaHandler(session);
+    }
+
+    video_track->onOpen([this, video_track = std::weak_ptr<rtc::Track>(video_track)]() {
+        if (auto track = video_track.lock()) {
+            track->requestBitrate(this->conn_info.bitrate * 1000);
+        }
+
+        // Frames sent before the track opened are lost, so the decoder would otherwise have to wait for the next periodic keyframe
+        // This is also what resumes the picture after a reconnection, since the decoder's reference frames came from the old connection
+        keyframe_requester->request();
+        startup_timer->mark(StartupPhase::TrackOpen);
+    });
 
     cancel_token = std::make_shared<std::atomic<bool>>(false);
     gathering_waiter = std::make_shared<Waiter>();
 
-    conn->onGatheringStateChange([gathering_waiter_ptr = gathering_waiter](rtc::PeerConnection::GatheringState state) {
+    if (this->conn_info.trickle_ice) {
+        trickle_ice = std::make_shared<TrickleIce>(conn, SignalingClient::get(this->conn_info.address, this->conn_info.verify_certs), this->conn_info.password);
+        conn->onLocalCandidate([trickle_ice = trickle_ice](rtc::Candidate candidate) {
+            trickle_ice->add_local_candidate(std::move(candidate));
+        });
+    }
+
+    conn->onGatheringStateChange([gathering_waiter_ptr = gathering_waiter, trickle_ice = trickle_ice](rtc::PeerConnection::GatheringState state) {
         if (state == rtc::PeerConnection::GatheringState::Complete) {
             gathering_waiter_ptr->notify_one();
+            if (trickle_ice) trickle_ice->complete_gathering();
         }
     });
-    conn->setLocalDescription();
+
+    // Gathering may have completed before the callback was replaced
+    if (conn->gatheringState() == rtc::PeerConnection::GatheringState::Complete) {
+        gathering_waiter->notify_one();
+        if (trickle_ice) trickle_ice->complete_gathering();
+    }
+
+    // Failures are noticed as soon as the connection reports them, instead of by polling its state
+    health_monitor->attach(health_channel);
+    conn->onStateChange([health_monitor = health_monitor](rtc::PeerConnection::State state) {
+        health_monitor->on_state_change(state);
+    });
+    conn->onIceStateChange([health_monitor = health_monitor](rtc::PeerConnection::IceState state) {
+        health_monitor->on_ice_state_change(state);
+    });
+    health_subscription = health_monitor->subscribe([this, cancel_token_copy = cancel_token](HealthState state) {
+        if (*cancel_token_copy) return;
+        awake([cancel_token_copy, this]() {
+            if (*cancel_token_copy) return;
+            handle_health_change();
+        });
+    });
 
     auto cancel_token_copy = cancel_token;
     auto gathering_waiter_copy = gathering_waiter;
     auto conn_info_copy = this->conn_info;
     auto conn_copy = conn;
+    auto startup_timer_copy = startup_timer;
+    auto stream_id_copy = stream_id;
+    bool resume = reconnect_attempts;
 
-    std::thread([this, cancel_token_copy, gathering_waiter_copy, conn_info_copy, conn_copy]() {
-        if (!gathering_waiter_copy->wait_for(std::chrono::seconds(5))) {
+    std::thread([this, cancel_token_copy, gathering_waiter_copy, conn_info_copy, conn_copy, startup_timer_copy, stream_id_copy, resume]() {
+        // With trickle ICE, the offer carries whatever has been gathered so far and the rest is sent once the server has answered
+        if (!conn_info_copy.trickle_ice && !gathering_waiter_copy->wait_for(std::chrono::seconds(5))) {
             if (*cancel_token_copy) return;
             awake([cancel_token_copy, this]() {
                 if (*cancel_token_copy) return;
                 connection_error = true;
                 fl_alert("Failed to connect: Timed out waiting for ICE gathering to complete");
+                end_stream();
             });
             return;
         }
 
         if (*cancel_token_copy) return;
+        if (!conn_info_copy.trickle_ice) {
+            startup_timer_copy->mark(StartupPhase::IceGathered);
+        }
 
         std::string offer;
         {
@@ -122,23 +840,26 @@ VideoWindow::VideoWindow(int x, int y, int width, int height, ConnectionInfo con
             {"show_mouse", conn_info_copy.view_only || !conn_info_copy.client_side_mouse},
             {"offer", pw::base64_encode(offer.data(), offer.size())},
         };
+        if (conn_info_copy.trickle_ice) {
+            req_json["trickle"] = true;
+        }
 
-        pw::HTTPResponse resp;
-        if (auto fetch_res = pw::fetch("POST",
-                "https://" + conn_info_copy.address + "/offer",
-                resp,
-                req_json.dump(),
-                {{"Content-Type", "application/json"}},
-                {
-                    .send_timeout = std::chrono::seconds(5),
-                    .recv_timeout = std::chrono::seconds(5),
-                    .verify_mode = conn_info_copy.verify_certs ? SSL_VERIFY_PEER : SSL_VERIFY_NONE,
-                }); !fetch_res) {
+        // A reconnection sends the same stream ID with resume set, so that the server continues the old session's state,
+        // like its file transfers, instead of starting a new one; servers that don't link them cancel the transfers
+        req_json["stream"] = stream_id_copy;
+        if (resume) {
+            req_json["resume"] = true;
+        }
+
+        // The connection is kept alive afterwards, so reconnecting to the same server skips both handshakes
+        SignalingResponse resp;
+        if (std::string err; !SignalingClient::get(conn_info_copy.address, conn_info_copy.verify_certs)->post("/offer", req_json.dump(), resp, err)) {
             if (*cancel_token_copy) return;
-            awake([cancel_token_copy, this, err = fetch_res.error().message()]() {
+            awake([cancel_token_copy, this, err]() {
                 if (*cancel_token_copy) return;
                 connection_error = true;
                 fl_alert("Failed to connect: %s", err.c_str());
+                end_stream();
             });
             return;
         } else if (resp.status_code != 200) {
@@ -147,278 +868,763 @@ VideoWindow::VideoWindow(int x, int y, int width, int height, ConnectionInfo con
                 if (*cancel_token_copy) return;
                 connection_error = true;
                 fl_alert("Failed to login: Response has status code %" PRIu16, status_code);
+                end_stream();
             });
             return;
         }
 
         if (*cancel_token_copy) return;
 
-        std::unique_ptr<rtc::Description> answer;
-        try {
-            json resp_json = json::parse(resp.body_string());
-            json answer_json = json::parse(pw::base64_decode(resp_json["Offer"].get<std::string>()));
-            answer = std::make_unique<rtc::Description>(answer_json["sdp"].get<std::string>(), answer_json["type"].get<std::string>());
-        } catch (const std::exception& e) {
-            if (*cancel_token_copy) return;
-            awake([cancel_token_copy, this, err = std::string(e.what())]() {
-                if (*cancel_token_copy) return;
-                connection_error = true;
-                fl_alert("Failed to start streaming: Failed to parse server answer: %s", err.c_str());
-            });
-            return;
+        std::unique_ptr<rtc::Description> answer;
+        std::string trickle_session; // Empty if the server doesn't support trickle ICE
+        try {
+            json resp_json = json::parse(resp.body);
+            json answer_json = json::parse(pw::base64_decode(resp_json["Offer"].get<std::string>()));
+            answer = std::make_unique<rtc::Description>(answer_json["sdp"].get<std::string>(), answer_json["type"].get<std::string>());
+            if (auto session_it = resp_json.find("Session"); session_it != resp_json.end() && session_it->is_string()) {
+                trickle_session = *session_it;
+            }
+        } catch (const std::exception& e) {
+            if (*cancel_token_copy) return;
+            awake([cancel_token_copy, this, err = std::string(e.what())]() {
+                if (*cancel_token_copy) return;
+                connection_error = true;
+                fl_alert("Failed to start streaming: Failed to parse server answer: %s", err.c_str());
+                end_stream();
+            });
+            return;
+        }
+
+        if (*cancel_token_copy) return;
+        startup_timer_copy->mark(StartupPhase::AnswerReceived);
+
+        std::shared_ptr<rtc::Description> answer_shared = std::move(answer);
+        awake([cancel_token_copy, this, answer_shared, conn_copy, trickle_session, signaling_timing = resp.timing]() {
+            if (*cancel_token_copy) return;
+            offer_timing = signaling_timing;
+
+            // The pipeline was built for the preferred codec, so it only needs replacing if the server chose another one
+            // This is rare enough that a pipeline which has already started is rebuilt here rather than in the background
+            if (auto codec = get_answered_video_codec(*answer_shared); codec && *codec != video_codec) {
+                video_codec = *codec;
+                if (playing) {
+                    std::string error;
+                    std::unique_ptr<VideoPipeline> pipeline;
+                    if (!(pipeline = build_video_pipeline(this->conn_info, video_codec, error))) {
+                        connection_error = true;
+                        fl_alert("%s", error.c_str());
+                        end_stream();
+                        return;
+                    }
+                    install_video_pipeline(std::move(pipeline));
+                }
+            }
+
+            std::optional<double> frame_rate = get_answered_media_attribute(*answer_shared, "video", "framerate");
+            std::optional<double> audio_packet_time = get_answered_media_attribute(*answer_shared, "audio", "ptime");
+            health_monitor->set_stall_timeout(get_stall_timeout(frame_rate && *frame_rate > 0. ? *frame_rate : DEFAULT_FRAME_RATE,
+                audio_packet_time && *audio_packet_time > 0. ? *audio_packet_time : DEFAULT_AUDIO_PACKET_TIME));
+
+            conn_copy->setRemoteDescription(*answer_shared);
+            if (trickle_ice && !trickle_session.empty()) {
+                trickle_ice->start(trickle_session);
+            }
+            connected = true;
+            if (!this->conn_info.view_only && Fl::belowmouse() == this && Fl::focus()) {
+                keyboard_grab_manager->grab_keyboard();
+            }
+        });
+    }).detach();
+}
+
+bool VideoWindow::is_connected() const {
+    return connected;
+}
+
+bool VideoWindow::has_connection_error() const {
+    return connection_error;
+}
+
+bool VideoWindow::is_playing() const {
+    return playing;
+}
+
+rtc::PeerConnection::IceState VideoWindow::ice_state() const {
+    return conn->iceState();
+}
+
+bool VideoWindow::reconnect() {
+    Fl::remove_timeout(stall_timer_callback, this);
+    if (!playing || reconnect_attempts >= MAX_RECONNECT_ATTEMPTS) {
+        return false;
+    }
+    reconnect_attempts++;
+
+    // libdatachannel can't restart ICE on an existing connection, but a new one only costs a round trip now that
+    // the signaling connection is kept alive and the DTLS certificate is cached
+    // The new offer is marked as resuming this window's stream, which is what lets the server resume its file transfers
+    stop_signaling();
+    video_track->onMessage(nullptr, nullptr);
+    audio_track->onMessage(nullptr, nullptr);
+    conn->onStateChange(nullptr);
+    conn->onIceStateChange(nullptr);
+    conn->close();
+    attach_connection(std::make_unique<PreparedConnection>(conn_info));
+
+    // The pipelines keep running, so their jitter buffers resynchronize on the new streams instead of being rebuilt
+    if (video_ingest) {
+        video_track->onMessage([video_ingest = video_ingest, health_monitor = health_monitor](rtc::binary message) {
+            health_monitor->on_packet();
+            video_ingest->push(std::move(message));
+        },
+            nullptr);
+    }
+    if (audio_ingest) {
+        audio_track->onMessage([audio_ingest = audio_ingest, health_monitor = health_monitor](rtc::binary message) {
+            health_monitor->on_packet();
+            audio_ingest->push(std::move(message));
+        },
+            nullptr);
+    }
+    file_manager->set_channel(ordered_channel);
+    return true;
+}
+
+void VideoWindow::show() {
+    Fl_Double_Window::show();
+    Fl::flush(); // Force the underlying OS window to be realized so that GStreamer can find it
+
+    loading_start_time = std::chrono::steady_clock::now();
+    Fl::add_timeout(1.0 / 60.0, loading_timer_callback, this);
+    if (conn_info.adaptive_bitrate) {
+        last_bitrate_statistics = {};
+        bitrate_controller.reset(conn_info.bitrate);
+        Fl::add_timeout(BITRATE_UPDATE_INTERVAL, bitrate_timer_callback, this);
+    }
+    Fl::add_timeout(AUDIO_JITTERBUFFER_UPDATE_INTERVAL, audio_jitterbuffer_timer_callback, this);
+    Fl::add_timeout(SYNC_UPDATE_INTERVAL, sync_timer_callback, this);
+
+    if (!conn_info.view_only) {
+        if (!conn_info.client_side_mouse) {
+            mouse_manager = std::make_unique<RawMouseManager>(this);
+            Fl::add_system_handler(&VideoWindow::system_event_handler, this);
+        }
+        keyboard_grab_manager = std::make_unique<KeyboardGrabManager>(top_window());
+    }
+
+    // Pipelines that are still being built are started as soon as they're ready
+    if (pending_video_pipeline) {
+        start_pending_pipelines();
+    }
+
+    take_focus();
+}
+
+void VideoWindow::hide() {
+    Fl::remove_timeout(loading_timer_callback, this);
+    Fl::remove_timeout(statistics_timer_callback, this);
+    Fl::remove_timeout(bitrate_timer_callback, this);
+    Fl::remove_timeout(audio_jitterbuffer_timer_callback, this);
+    Fl::remove_timeout(sync_timer_callback, this);
+    Fl::remove_timeout(stall_timer_callback, this);
+    stop_signaling();
+
+    if (!conn_info.view_only) {
+        if (!conn_info.client_side_mouse) {
+            Fl::remove_system_handler(&VideoWindow::system_event_handler);
+            mouse_manager.reset();
+        }
+        keyboard_grab_manager.reset();
+    }
+    file_manager.reset();
+    if (ordered_channel->isOpen()) {
+        json message = {
+            {"type", "disconnect"},
+        };
+        ordered_channel->send(message.dump());
+    }
+    conn->close();
+    connected = false;
+
+    // The builders reference the window, so it must outlive them
+    *pipeline_cancel_token = true;
+    if (pipeline_thread.joinable()) {
+        pipeline_thread.join();
+    }
+    pending_video_pipeline.reset();
+    pending_audio_pipeline.reset();
+    destroy_video_pipeline();
+    if (audio_pipeline) {
+        stop_pipeline(audio_pipeline.get());
+        audio_pipeline.reset();
+    }
+    audio_jitterbuffer = nullptr;
+    audio_ingest.reset();
+    audio_latency_tracker.reset();
+    audio_bus_monitor.reset();
+    playing = false;
+
+    Fl_Double_Window::hide();
+}
+
+void VideoWindow::stop_signaling() {
+    if (cancel_token) {
+        *cancel_token = true;
+        cancel_token.reset();
+    }
+    if (gathering_waiter) {
+        gathering_waiter->notify_all();
+        gathering_waiter.reset();
+    }
+    if (trickle_ice) {
+        trickle_ice->stop();
+        trickle_ice.reset();
+    }
+    if (health_subscription) {
+        health_monitor->unsubscribe(*health_subscription);
+        health_subscription.reset();
+    }
+}
+
+void VideoWindow::handle_health_change() {
+    switch (health_monitor->get_stats().state) {
+    case HealthState::Healthy:
+    case HealthState::Degraded:
+        Fl::remove_timeout(stall_timer_callback, this);
+        reconnect_attempts = 0;
+        break;
+
+    case HealthState::Stalled:
+        if (conn->iceState() == rtc::PeerConnection::IceState::Disconnected) {
+            // ICE may regain consent by itself, so the connection is only replaced if it doesn't within the grace period
+            if (!Fl::has_timeout(stall_timer_callback, this)) {
+                Fl::add_timeout(ICE_DISCONNECTED_GRACE, stall_timer_callback, this);
+            }
+        } else {
+            // Media stalls are acted on right away, since the decoder needs a keyframe to recover from the gap once packets flow again
+            // The requester is rate-limited, so a server that keeps going idle isn't flooded, and a dead connection loses ICE consent, handled above
+            Fl::remove_timeout(stall_timer_callback, this);
+            keyframe_requester->request();
         }
+        break;
 
-        if (*cancel_token_copy) return;
+    case HealthState::Failed:
+        if (!reconnect()) {
+            end_stream();
+        }
+        break;
 
-        std::shared_ptr<rtc::Description> answer_shared = std::move(answer);
-        awake([cancel_token_copy, this, answer_shared, conn_copy]() {
-            if (*cancel_token_copy) return;
-            conn_copy->setRemoteDescription(*answer_shared);
-            connected = true;
-            if (!this->conn_info.view_only && Fl::belowmouse() == this && Fl::focus()) {
-                keyboard_grab_manager->grab_keyboard();
-            }
-        });
-    }).detach();
+    default:
+        break;
+    }
 }
 
-bool VideoWindow::is_connected() const {
-    return connected;
+void VideoWindow::end_stream() {
+    if (stream_end_cb) {
+        stream_end_cb();
+    }
 }
 
-bool VideoWindow::has_connection_error() const {
-    return connection_error;
+void VideoWindow::use_shared_clock(GstElement* pipeline) {
+    // Without a start time, the pipeline keeps the base time it is given instead of picking a new one when it starts playing
+    gst_pipeline_use_clock(GST_PIPELINE(pipeline), pipeline_clock.get());
+    gst_element_set_start_time(pipeline, GST_CLOCK_TIME_NONE);
+    gst_element_set_base_time(pipeline, pipeline_base_time);
 }
 
-bool VideoWindow::is_playing() const {
-    return playing;
+VideoWindow::VideoPipeline::~VideoPipeline() {
+    if (pipeline) stop_pipeline(pipeline.get());
 }
 
-rtc::PeerConnection::IceState VideoWindow::ice_state() const {
-    return conn->iceState();
+VideoWindow::AudioPipeline::~AudioPipeline() {
+    if (pipeline) stop_pipeline(pipeline.get());
 }
 
-void VideoWindow::show() {
-    Fl_Double_Window::show();
-    Fl::flush(); // Force the underlying OS window to be realized so that GStreamer can find it
-
-    loading_start_time = std::chrono::steady_clock::now();
-    Fl::add_timeout(1.0 / 60.0, loading_timer_callback, this);
+// Builds the receive pipeline for the codec and brings it to READY, which opens the decoder and the sink's display connection
+std::unique_ptr<VideoWindow::VideoPipeline> VideoWindow::build_video_pipeline(const ConnectionInfo& conn_info, VideoCodec codec, std::string& error) {
+    VideoCodecSettings codec_settings = get_video_codec_settings(codec);
 
-    if (!conn_info.view_only) {
-        if (!conn_info.client_side_mouse) {
-            mouse_manager = std::make_unique<RawMouseManager>(this);
-            Fl::add_system_handler(&VideoWindow::system_event_handler, this);
+    // The pipeline is destroyed along with ret if the build fails, so its floating reference is taken over right away
+    auto ret = std::make_unique<VideoPipeline>();
+    ret->codec = codec;
+    ret->pipeline = (GstElement*) gst_object_ref_sink(gst_pipeline_new(nullptr));
+    use_shared_clock(ret->pipeline.get());
+    GstElement* appsrc = gst_element_factory_make("appsrc", nullptr);
+    {
+        GstCaps* caps = gst_caps_new_simple("application/x-rtp", "media", G_TYPE_STRING, "video", "encoding-name", G_TYPE_STRING, codec_settings.encoding_name, "clock-rate", G_TYPE_INT, 90000, nullptr);
+        g_object_set(appsrc, "caps", caps, "emit-signals", FALSE, "format", GST_FORMAT_TIME, "is-live", TRUE, "do-timestamp", FALSE, nullptr);
+        gst_caps_unref(caps);
+    }
+    ret->ingest = std::make_shared<TrackIngest>(appsrc, true, 256, 4096);
+    ret->latency_tracker = std::make_shared<LatencyTracker>();
+    ret->ingest->set_latency_tracker(ret->latency_tracker);
+
+    // RED is unwrapped before the jitter buffer and the payloads are stored so that the FEC decoder can rebuild lost packets from them
+    // The FEC decoder sits after the jitter buffer because it acts on the jitter buffer's packet loss events
+    GstElement* rtpreddec = nullptr;
+    GstElement* rtpstorage = nullptr;
+    GstElement* rtpulpfecdec = nullptr;
+    if (conn_info.fec) {
+        rtpreddec = gst_element_factory_make("rtpreddec", nullptr);
+        rtpstorage = gst_element_factory_make("rtpstorage", nullptr);
+        rtpulpfecdec = gst_element_factory_make("rtpulpfecdec", nullptr);
+        if (rtpreddec && rtpstorage && rtpulpfecdec) {
+            g_object_set(rtpreddec, "pt", VIDEO_RED_PAYLOAD_TYPE, nullptr);
+            g_object_set(rtpstorage, "size-time", (guint64) (250 * GST_MSECOND), nullptr);
+
+            GObject* storage;
+            g_object_get(rtpstorage, "internal-storage", &storage, nullptr);
+            g_object_set(rtpulpfecdec, "pt", VIDEO_ULPFEC_PAYLOAD_TYPE, "storage", storage, nullptr);
+            g_object_unref(storage);
+        } else {
+            unref_floating_elements({rtpreddec, rtpstorage, rtpulpfecdec});
+            rtpreddec = rtpstorage = rtpulpfecdec = nullptr;
         }
-        keyboard_grab_manager = std::make_unique<KeyboardGrabManager>(top_window());
     }
 
-    video_pipeline = gst_pipeline_new(nullptr);
+    GstElement* rtpjitterbuffer = gst_element_factory_make("rtpjitterbuffer", nullptr);
+    if (rtpulpfecdec) {
+        g_object_set(rtpjitterbuffer, "do-lost", TRUE, nullptr);
+    }
+
+    // The jitter buffer accepts packets without limit, so a stalled decoder would otherwise build up an unbounded backlog
+    // Instead, the oldest packets are dropped once the backlog exceeds the cap and a keyframe is requested to resynchronize
+    GstElement* queue = gst_element_factory_make("queue", nullptr);
+    g_object_set(queue, "max-size-buffers", 0, "max-size-bytes", 0, "leaky", 2 /* Downstream */, nullptr);
+    glib::connect_signal(queue, "overrun", [this](GstElement* queue) {
+        handle_video_queue_overrun();
+    });
+
+    // Hardware decoders need parsed input, and the parser passes through anything the depayloader already aligned
+    // Neither is guaranteed to be installed for the less common codecs
+    GstElement* depay = gst_element_factory_make(codec_settings.depayloader, nullptr);
+    GstElement* parser = gst_element_factory_make(codec_settings.parser, nullptr);
+    if (!depay || !parser) {
+        unref_floating_elements({appsrc, rtpreddec, rtpstorage, rtpulpfecdec, rtpjitterbuffer, queue, depay, parser});
+        error = std::string("Failed to create GStreamer ") + codec_settings.encoding_name + " depayloader or parser (video pipeline)";
+        return nullptr;
+    }
     {
-        GstElement* appsrc = gst_element_factory_make("appsrc", nullptr);
-        {
-            GstCaps* caps = gst_caps_new_simple("application/x-rtp", "media", G_TYPE_STRING, "video", "encoding-name", G_TYPE_STRING, "H264", "clock-rate", G_TYPE_INT, 90000, nullptr);
-            g_object_set(appsrc, "caps", caps, "emit-signals", FALSE, "format", GST_FORMAT_TIME, "is-live", TRUE, "do-timestamp", TRUE, nullptr);
-            gst_caps_unref(caps);
+        GObjectClass* klass = G_OBJECT_GET_CLASS(depay);
+        if (g_object_class_find_property(klass, "request-keyframe")) {
+            g_object_set(depay, "request-keyframe", TRUE, nullptr);
         }
-        video_track->onMessage([appsrc](rtc::binary message) {
-            GstBuffer* buf = gst_buffer_new_and_alloc(message.size());
+        if (g_object_class_find_property(klass, "wait-for-keyframe")) {
+            g_object_set(depay, "wait-for-keyframe", conn_info.error_concealment == ErrorConcealment::FreezeOnLastGood, nullptr);
+        }
+
+        // The depayloader and decoder ask for keyframes with upstream events when they detect loss or corruption
+        glib::Object<GstPad> sink_pad = gst_element_get_static_pad(depay, "sink");
+        gst_pad_add_probe(sink_pad.get(), GST_PAD_PROBE_TYPE_EVENT_UPSTREAM, [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+            if (gst_video_event_is_force_key_unit(GST_PAD_PROBE_INFO_EVENT(info))) {
+                ((KeyframeRequester*) data)->request();
+                return GST_PAD_PROBE_DROP;
+            }
+            return GST_PAD_PROBE_OK;
+        },
+            keyframe_requester.get(),
+            nullptr);
 
-            GstMapInfo map;
-            gst_buffer_map(buf, &map, GST_MAP_WRITE);
-            memcpy(map.data, message.data(), message.size());
-            gst_buffer_unmap(buf, &map);
+        glib::Object<GstPad> src_pad = gst_element_get_static_pad(depay, "src");
+        gst_pad_add_probe(src_pad.get(), GST_PAD_PROBE_TYPE_BUFFER, [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+            if (!GST_BUFFER_FLAG_IS_SET(GST_PAD_PROBE_INFO_BUFFER(info), GST_BUFFER_FLAG_DELTA_UNIT)) {
+                ((KeyframeRequester*) data)->on_keyframe();
+            }
+            return GST_PAD_PROBE_OK;
+        },
+            keyframe_requester.get(),
+            nullptr);
+    }
 
-            GstFlowReturn flow;
-            g_signal_emit_by_name(appsrc, "push-buffer", buf, &flow);
-            gst_buffer_unref(buf);
+    GstElement* decoder;
+    if (!(decoder = make_video_decoder(conn_info, codec_settings))) {
+        unref_floating_elements({appsrc, rtpreddec, rtpstorage, rtpulpfecdec, rtpjitterbuffer, queue, depay, parser});
+        error = std::string("Failed to create GStreamer ") + codec_settings.encoding_name + " decoder (video pipeline)";
+        return nullptr;
+    }
+    {
+        glib::Object<GstPad> pad = gst_element_get_static_pad(decoder, "src");
+        gst_pad_add_probe(pad.get(), GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+            auto video_info = (VideoInfo*) data;
+            GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+            if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+                GstCaps* caps;
+                gst_event_parse_caps(event, &caps);
+
+                GstStructure* structure = gst_caps_get_structure(caps, 0);
+                video_info->mutex.lock();
+                gst_structure_get_int(structure, "width", &video_info->width);
+                gst_structure_get_int(structure, "height", &video_info->height);
+                video_info->mutex.unlock();
+            }
+            return GST_PAD_PROBE_OK;
         },
+            &video_info,
+            nullptr);
+        gst_pad_add_probe(pad.get(), GST_PAD_PROBE_TYPE_BUFFER, [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+            ((RateCounter*) data)->add();
+            return GST_PAD_PROBE_OK;
+        },
+            &decoded_frames,
+            nullptr);
+        gst_pad_add_probe(pad.get(), GST_PAD_PROBE_TYPE_BUFFER, [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+            ((PhaseTimer<StartupPhase>*) data)->mark(StartupPhase::FirstFrame);
+            return GST_PAD_PROBE_REMOVE;
+        },
+            startup_timer.get(),
             nullptr);
 
-        GstElement* rtpjitterbuffer = gst_element_factory_make("rtpjitterbuffer", nullptr);
-        g_object_set(rtpjitterbuffer, "latency", 0, nullptr);
+        gboolean direct_rendering = FALSE;
+        if (g_object_class_find_property(G_OBJECT_GET_CLASS(decoder), "direct-rendering")) {
+            g_object_get(decoder, "direct-rendering", &direct_rendering, nullptr);
+        }
+        if (direct_rendering) {
+            // Runs after downstream has answered the allocation query
+            gst_pad_add_probe(pad.get(), (GstPadProbeType) (GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM | GST_PAD_PROBE_TYPE_PULL), [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+                auto window = (VideoWindow*) data;
+                GstQuery* query = GST_PAD_PROBE_INFO_QUERY(info);
+                if (GST_QUERY_TYPE(query) != GST_QUERY_ALLOCATION) {
+                    return GST_PAD_PROBE_OK;
+                }
+                window->proposed_zero_copy_state = ZeroCopyState::Off;
+                window->zero_copy_pool = nullptr;
 
-        GstElement* rtph264depay = gst_element_factory_make("rtph264depay", nullptr);
+                // Decoders only render directly into buffers whose strides they can describe with video meta
+                if (!gst_query_find_allocation_meta(query, GST_VIDEO_META_API_TYPE, nullptr)) {
+                    return GST_PAD_PROBE_OK;
+                }
 
-#ifdef _WIN32
-        GstElement* h264parse = gst_element_factory_make("h264parse", nullptr);
+                if (gst_query_get_n_allocation_pools(query)) {
+                    GstBufferPool* pool;
+                    gst_query_parse_nth_allocation_pool(query, 0, &pool, nullptr, nullptr, nullptr);
+                    if (pool) {
+                        window->proposed_zero_copy_state = ZeroCopyState::SinkPool;
+                        window->zero_copy_pool = pool;
+                        gst_object_unref(pool);
+                    }
+                    return GST_PAD_PROBE_OK;
+                }
 
-        GstElement* h264dec = gst_element_factory_make("d3d11h264dec", nullptr);
-#else
-        GstElement* h264dec = gst_element_factory_make("avdec_h264", nullptr);
-        g_object_set(h264dec, "direct-rendering", FALSE, nullptr);
-#endif
-        {
-            glib::Object<GstPad> pad = gst_element_get_static_pad(h264dec, "src");
-            gst_pad_add_probe(pad.get(), GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, [](GstPad* pad, GstPadProbeInfo* info, void* data) {
-                auto video_info = (VideoInfo*) data;
-                GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
-                if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
-                    GstCaps* caps;
-                    gst_event_parse_caps(event, &caps);
-
-                    GstStructure* structure = gst_caps_get_structure(caps, 0);
-                    video_info->mutex.lock();
-                    gst_structure_get_int(structure, "width", &video_info->width);
-                    gst_structure_get_int(structure, "height", &video_info->height);
-                    video_info->mutex.unlock();
+                // Without a proposed pool, the decoder would fall back to decoding into its own memory and copying out
+                GstCaps* caps;
+                GstVideoInfo video_info;
+                gst_query_parse_allocation(query, &caps, nullptr);
+                if (!caps || !gst_video_info_from_caps(&video_info, caps)) {
+                    return GST_PAD_PROBE_OK;
+                }
+
+                // libavcodec decodes whole macroblocks into SIMD-aligned rows, and avviddec won't use a pool without room for that
+                GstVideoAlignment alignment;
+                gst_video_alignment_reset(&alignment);
+                alignment.padding_right = GST_ROUND_UP_64(GST_VIDEO_INFO_WIDTH(&video_info)) - GST_VIDEO_INFO_WIDTH(&video_info);
+                alignment.padding_bottom = GST_ROUND_UP_64(GST_VIDEO_INFO_HEIGHT(&video_info)) - GST_VIDEO_INFO_HEIGHT(&video_info);
+                for (unsigned int i = 0; i < GST_VIDEO_MAX_PLANES; ++i) {
+                    alignment.stride_align[i] = 63;
+                }
+                if (!gst_video_info_align(&video_info, &alignment)) {
+                    return GST_PAD_PROBE_OK;
                 }
+
+                // libavcodec keeps reference frames alive, so the pool must be allowed to grow
+                GstBufferPool* pool = gst_video_buffer_pool_new();
+                GstStructure* config = gst_buffer_pool_get_config(pool);
+                gst_buffer_pool_config_set_params(config, caps, video_info.size, 2, 0);
+                gst_buffer_pool_config_add_option(config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+                gst_buffer_pool_config_add_option(config, GST_BUFFER_POOL_OPTION_VIDEO_ALIGNMENT);
+                gst_buffer_pool_config_set_video_alignment(config, &alignment);
+                if (gst_buffer_pool_set_config(pool, config)) {
+                    gst_query_add_allocation_pool(query, pool, video_info.size, 2, 0);
+                    window->proposed_zero_copy_state = ZeroCopyState::NegotiatedPool;
+                    window->zero_copy_pool = pool;
+                }
+                gst_object_unref(pool);
+                return GST_PAD_PROBE_OK;
+            },
+                this,
+                nullptr);
+
+            // The decoder may still reject the pool and copy into it, so only frames that come out of it count
+            // The pool is only compared against, never used, so it doesn't matter if it has been freed
+            gst_pad_add_probe(pad.get(), GST_PAD_PROBE_TYPE_BUFFER, [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+                auto window = (VideoWindow*) data;
+                GstBuffer* buf = GST_PAD_PROBE_INFO_BUFFER(info);
+                window->zero_copy_state = buf->pool && buf->pool == window->zero_copy_pool ? window->proposed_zero_copy_state.load() : ZeroCopyState::Off;
                 return GST_PAD_PROBE_OK;
             },
-                &video_info,
+                this,
                 nullptr);
         }
+    }
 
-#ifdef _WIN32
-        GstElement* videosink = gst_element_factory_make("d3d11videosink", nullptr);
-        g_object_set(videosink, "enable-navigation-events", FALSE, nullptr);
-#elif defined(__APPLE__)
-        GstElement* videosink = gst_element_factory_make("osxvideosink", nullptr);
-#else
-        GstElement* videosink = gst_element_factory_make("xvimagesink", nullptr);
-#endif
-        g_object_set(videosink, "max-lateness", 0, nullptr);
+    // The statistics overlay stays silent, passing frames through untouched, while the statistics are hidden
+    // Sinks that render overlay composition meta draw it themselves, otherwise it is blended into the decoder's frames,
+    // which aren't writable when they come from a shared pool, so each is copied while the statistics are shown
+    GstElement* statistics_overlay;
+    if ((statistics_overlay = gst_element_factory_make("textoverlay", nullptr))) {
+        g_object_set(statistics_overlay,
+            "silent",
+            TRUE,
+            "valignment",
+            2, // Top
+            "halignment",
+            0, // Left
+            "line-alignment",
+            0, // Left
+            "shaded-background",
+            TRUE,
+            "font-desc",
+            "Monospace 10",
+            nullptr);
 
-        gst_bin_add_many(GST_BIN(video_pipeline.get()),
-            appsrc,
-            rtpjitterbuffer,
-            rtph264depay,
-#ifdef _WIN32
-            h264parse,
-#endif
-            h264dec,
-            videosink,
+        // Runs after downstream has answered the allocation query
+        glib::Object<GstPad> pad = gst_element_get_static_pad(statistics_overlay, "src");
+        gst_pad_add_probe(pad.get(), (GstPadProbeType) (GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM | GST_PAD_PROBE_TYPE_PULL), [](GstPad* pad, GstPadProbeInfo* info, void* data) {
+            auto overlay_composition_state = (std::atomic<OverlayCompositionState>*) data;
+            if (GstQuery* query = GST_PAD_PROBE_INFO_QUERY(info); GST_QUERY_TYPE(query) == GST_QUERY_ALLOCATION) {
+                *overlay_composition_state = gst_query_find_allocation_meta(query, GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE, nullptr) ? OverlayCompositionState::Supported : OverlayCompositionState::Unsupported;
+            }
+            return GST_PAD_PROBE_OK;
+        },
+            &overlay_composition_state,
             nullptr);
-        if (!gst_element_link_many(
-                appsrc,
-                rtpjitterbuffer,
-                rtph264depay,
+    }
+
+    GstElement* videosink = gst_element_factory_make(VIDEO_SINK, nullptr);
 #ifdef _WIN32
-                h264parse,
+    g_object_set(videosink, "enable-navigation-events", FALSE, nullptr);
 #endif
-                h264dec,
-                videosink,
-                nullptr)) {
-            fl_alert("Failed to link GStreamer elements (video pipeline)");
-            return;
-        }
 
-        gst_video_overlay_handle_events(GST_VIDEO_OVERLAY(videosink), FALSE);
+    ret->latency_tracker->attach(rtpjitterbuffer, depay, decoder, videosink);
+
+    gst_bin_add_many(GST_BIN(ret->pipeline.get()),
+        appsrc,
+        rtpjitterbuffer,
+        queue,
+        depay,
+        parser,
+        decoder,
+        videosink,
+        nullptr);
+    if (rtpulpfecdec) {
+        gst_bin_add_many(GST_BIN(ret->pipeline.get()), rtpreddec, rtpstorage, rtpulpfecdec, nullptr);
+    }
+    if (statistics_overlay) {
+        gst_bin_add(GST_BIN(ret->pipeline.get()), statistics_overlay);
+    }
+    if (!(rtpulpfecdec ? gst_element_link_many(appsrc, rtpreddec, rtpstorage, rtpjitterbuffer, rtpulpfecdec, queue, nullptr) : gst_element_link_many(appsrc, rtpjitterbuffer, queue, nullptr)) ||
+        !gst_element_link_many(
+            queue,
+            depay,
+            parser,
+            decoder,
+            nullptr) ||
+        !(statistics_overlay ? gst_element_link_many(decoder, statistics_overlay, videosink, nullptr) : gst_element_link(decoder, videosink))) {
+        error = "Failed to link GStreamer elements (video pipeline)";
+        return nullptr;
+    }
+
+    gst_video_overlay_handle_events(GST_VIDEO_OVERLAY(videosink), FALSE);
+    ret->jitterbuffer = rtpjitterbuffer;
+    ret->queue = queue;
+    ret->fec_decoder = rtpulpfecdec;
+    ret->sink = videosink;
+    ret->statistics_overlay = statistics_overlay;
+
+    if (gst_element_set_state(ret->pipeline.get(), GST_STATE_READY) == GST_STATE_CHANGE_FAILURE) {
+        error = "Failed to start GStreamer video pipeline";
+        return nullptr;
+    }
+    return ret;
+}
+
+// Takes over a built pipeline, renders it into the window, and starts it
+void VideoWindow::install_video_pipeline(std::unique_ptr<VideoPipeline> pipeline) {
+    destroy_video_pipeline();
+    video_pipeline = std::move(pipeline->pipeline);
+    video_ingest = std::move(pipeline->ingest);
+    video_latency_tracker = std::move(pipeline->latency_tracker);
+    video_jitterbuffer = pipeline->jitterbuffer;
+    video_queue = pipeline->queue;
+    video_fec_decoder = pipeline->fec_decoder;
+    video_sink = pipeline->sink;
+    statistics_overlay = pipeline->statistics_overlay;
+    pipeline.reset();
+
+    // The probes only write these once data flows, which doesn't happen before the pipeline is started below
+    video_queue_overruns = 0;
+    zero_copy_state = ZeroCopyState::Off;
+    proposed_zero_copy_state = ZeroCopyState::Off;
+    zero_copy_pool = nullptr;
+    overlay_composition_state = OverlayCompositionState::Unknown;
+
+    video_track->onMessage([video_ingest = video_ingest, health_monitor = health_monitor](rtc::binary message) {
+        health_monitor->on_packet();
+        video_ingest->push(std::move(message));
+    },
+        nullptr);
+    av_sync->attach_video(video_jitterbuffer, video_sink);
+
 #ifdef _WIN32
-        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(videosink), (uintptr_t) fl_xid(this));
+    gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(video_sink), (uintptr_t) fl_xid(this));
 #elif defined(__APPLE__)
-        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(videosink), (uintptr_t) fl_xid(this));
+    gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(video_sink), (uintptr_t) fl_xid(this));
 #else
-        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(videosink), fl_xid(this));
+    gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(video_sink), fl_xid(this));
 #endif
-        overlay = GST_VIDEO_OVERLAY(videosink);
+    overlay = GST_VIDEO_OVERLAY(video_sink);
+    apply_latency_profile();
+
+    video_bus_monitor = std::make_unique<BusMonitor>(video_pipeline.get(), [keyframe_requester = keyframe_requester]() {
+        keyframe_requester->request();
+    });
+    start_pipeline(video_pipeline.get(), startup_timer, StartupPhase::PipelineStarted);
+}
+
+void VideoWindow::destroy_video_pipeline() {
+    overlay = nullptr;
+    video_jitterbuffer = nullptr;
+    video_queue = nullptr;
+    video_fec_decoder = nullptr;
+    video_sink = nullptr;
+    statistics_overlay = nullptr;
+    if (video_pipeline) {
+        stop_pipeline(video_pipeline.get());
+        video_pipeline.reset();
     }
+    video_ingest.reset();
+    video_latency_tracker.reset();
+    video_bus_monitor.reset();
+}
 
-    audio_pipeline = gst_pipeline_new(nullptr);
+std::unique_ptr<VideoWindow::AudioPipeline> VideoWindow::build_audio_pipeline(const ConnectionInfo& conn_info, std::string& error) {
+    auto ret = std::make_unique<AudioPipeline>();
+    ret->pipeline = (GstElement*) gst_object_ref_sink(gst_pipeline_new(nullptr));
+    use_shared_clock(ret->pipeline.get());
+
+    GstElement* appsrc = gst_element_factory_make("appsrc", nullptr);
     {
-        GstElement* appsrc = gst_element_factory_make("appsrc", nullptr);
-        {
-            GstCaps* caps = gst_caps_new_simple("application/x-rtp", "media", G_TYPE_STRING, "audio", "encoding-name", G_TYPE_STRING, "OPUS", "clock-rate", G_TYPE_INT, 48000, "payload", G_TYPE_INT, 97, nullptr);
-            g_object_set(appsrc, "caps", caps, "format", GST_FORMAT_TIME, "is-live", TRUE, "do-timestamp", TRUE, nullptr);
-            gst_caps_unref(caps);
-        }
-        audio_track->onMessage([appsrc](rtc::binary message) {
-            GstBuffer* buf = gst_buffer_new_and_alloc(message.size());
+        GstCaps* caps = gst_caps_new_simple("application/x-rtp", "media", G_TYPE_STRING, "audio", "encoding-name", G_TYPE_STRING, "OPUS", "clock-rate", G_TYPE_INT, 48000, "payload", G_TYPE_INT, 97, nullptr);
+        g_object_set(appsrc, "caps", caps, "emit-signals", FALSE, "format", GST_FORMAT_TIME, "is-live", TRUE, "do-timestamp", TRUE, nullptr);
+        gst_caps_unref(caps);
+    }
+    ret->ingest = std::make_shared<TrackIngest>(appsrc);
+    ret->latency_tracker = std::make_shared<LatencyTracker>(48000);
+    ret->ingest->set_latency_tracker(ret->latency_tracker);
 
-            GstMapInfo map;
-            gst_buffer_map(buf, &map, GST_MAP_WRITE);
-            memcpy(map.data, message.data(), message.size());
-            gst_buffer_unmap(buf, &map);
+    // Lost packets become gap events, which the decoder fills from the next packet's in-band FEC or by concealment
+    GstElement* rtpjitterbuffer = gst_element_factory_make("rtpjitterbuffer", nullptr);
+    g_object_set(rtpjitterbuffer, "do-lost", TRUE, nullptr);
+    gst_util_set_object_arg(G_OBJECT(rtpjitterbuffer), "mode", "slave");
 
-            GstFlowReturn flow;
-            g_signal_emit_by_name(appsrc, "push-buffer", buf, &flow);
-            gst_buffer_unref(buf);
-        },
-            nullptr);
+    GstElement* rtpopusdepay = gst_element_factory_make("rtpopusdepay", nullptr);
 
-        GstElement* rtpopusdepay = gst_element_factory_make("rtpopusdepay", nullptr);
+    GstElement* capsfilter = gst_element_factory_make("capsfilter", nullptr);
+    {
+        GstCaps* caps = gst_caps_new_simple("audio/x-opus", "channels", G_TYPE_INT, 2, nullptr);
+        g_object_set(capsfilter, "caps", caps, nullptr);
+        gst_caps_unref(caps);
+    }
 
-        GstElement* capsfilter = gst_element_factory_make("capsfilter", nullptr);
-        {
-            GstCaps* caps = gst_caps_new_simple("audio/x-opus", "channels", G_TYPE_INT, 2, nullptr);
-            g_object_set(capsfilter, "caps", caps, nullptr);
-            gst_caps_unref(caps);
-        }
+    GstElement* opusdec = gst_element_factory_make("opusdec", nullptr);
+    g_object_set(opusdec, "use-inband-fec", TRUE, "plc", TRUE, nullptr);
 
-        GstElement* opusdec = gst_element_factory_make("opusdec", nullptr);
+    GstElement* audioconvert = gst_element_factory_make("audioconvert", nullptr);
 
-        GstElement* audioconvert = gst_element_factory_make("audioconvert", nullptr);
+    GstElement* audioresample = gst_element_factory_make("audioresample", nullptr);
 
-        GstElement* autoaudiosink = gst_element_factory_make("autoaudiosink", nullptr);
+    // The ring buffer size is only read when the device is opened, so it follows the latency profile at connection time
+    // The device is slaved to the shared system clock and corrects its drift by resampling instead of skipping or repeating samples
+    GstElement* audiosink;
+    if ((audiosink = make_audio_sink())) {
+        LatencyProfileSettings settings = get_latency_profile_settings(conn_info.latency_profile);
+        GObjectClass* klass = G_OBJECT_GET_CLASS(audiosink);
+        if (g_object_class_find_property(klass, "buffer-time")) {
+            g_object_set(audiosink, "buffer-time", settings.audio_buffer_time, "latency-time", settings.audio_latency_time, nullptr);
+        }
+        if (g_object_class_find_property(klass, "slave-method")) {
+            gst_util_set_object_arg(G_OBJECT(audiosink), "slave-method", "resample");
+        }
+        if (g_object_class_find_property(klass, "low-latency")) {
+            g_object_set(audiosink, "low-latency", TRUE, nullptr);
+        }
+
+    } else {
+        audiosink = gst_element_factory_make("autoaudiosink", nullptr);
+    }
 
-        gst_bin_add_many(GST_BIN(audio_pipeline.get()),
-            appsrc,
+    // The latency tracker reads the sink's sync state, which autoaudiosink doesn't expose
+    ret->sink = GST_IS_BASE_SINK(audiosink) ? audiosink : nullptr;
+    ret->latency_tracker->attach(rtpjitterbuffer, rtpopusdepay, opusdec, ret->sink);
+
+    gst_bin_add_many(GST_BIN(ret->pipeline.get()),
+        appsrc,
+        rtpjitterbuffer,
+        rtpopusdepay,
+        capsfilter,
+        opusdec,
+        audioconvert,
+        audioresample,
+        audiosink,
+        nullptr);
+    if (!gst_element_link_many(appsrc,
+            rtpjitterbuffer,
             rtpopusdepay,
             capsfilter,
             opusdec,
             audioconvert,
-            autoaudiosink,
-            nullptr);
-        if (!gst_element_link_many(appsrc,
-                rtpopusdepay,
-                capsfilter,
-                opusdec,
-                audioconvert,
-                autoaudiosink,
-                nullptr)) {
-            fl_alert("Failed to link GStreamer elements (audio pipeline)");
-            return;
-        }
+            audioresample,
+            audiosink,
+            nullptr)) {
+        error = "Failed to link GStreamer elements (audio pipeline)";
+        return nullptr;
     }
+    ret->jitterbuffer = rtpjitterbuffer;
 
-    gst_element_set_state(video_pipeline.get(), GST_STATE_PLAYING);
-    gst_element_set_state(audio_pipeline.get(), GST_STATE_PLAYING);
-    playing = true;
-
-    take_focus();
+    if (gst_element_set_state(ret->pipeline.get(), GST_STATE_READY) == GST_STATE_CHANGE_FAILURE) {
+        error = "Failed to start GStreamer audio pipeline";
+        return nullptr;
+    }
+    return ret;
 }
 
-void VideoWindow::hide() {
-    Fl::remove_timeout(loading_timer_callback, this);
-
-    if (cancel_token) {
-        *cancel_token = true;
-        cancel_token.reset();
-    }
-    if (gathering_waiter) {
-        gathering_waiter->notify_all();
-        gathering_waiter.reset();
-    }
+void VideoWindow::install_audio_pipeline(std::unique_ptr<AudioPipeline> pipeline) {
+    audio_pipeline = std::move(pipeline->pipeline);
+    audio_ingest = std::move(pipeline->ingest);
+    audio_latency_tracker = std::move(pipeline->latency_tracker);
+    audio_jitterbuffer = pipeline->jitterbuffer;
+    GstElement* audiosink = pipeline->sink;
+    pipeline.reset();
+
+    audio_track->onMessage([audio_ingest = audio_ingest, health_monitor = health_monitor](rtc::binary message) {
+        health_monitor->on_packet();
+        audio_ingest->push(std::move(message));
+    },
+        nullptr);
+    av_sync->attach_audio(audio_jitterbuffer, audiosink);
+    apply_latency_profile();
+
+    audio_bus_monitor = std::make_unique<BusMonitor>(audio_pipeline.get());
+    start_pipeline(audio_pipeline.get());
+}
 
-    if (!conn_info.view_only) {
-        if (!conn_info.client_side_mouse) {
-            Fl::remove_system_handler(&VideoWindow::system_event_handler);
-            mouse_manager.reset();
+void VideoWindow::start_pending_pipelines() {
+    std::unique_ptr<VideoPipeline> video = std::move(pending_video_pipeline);
+    std::unique_ptr<AudioPipeline> audio = std::move(pending_audio_pipeline);
+
+    // The server may have answered with another codec while the pipelines were being built
+    if (video->codec != video_codec) {
+        std::string error;
+        if (!(video = build_video_pipeline(conn_info, video_codec, error))) {
+            connection_error = true;
+            fl_alert("%s", error.c_str());
+            end_stream();
+            return;
         }
-        keyboard_grab_manager.reset();
-    }
-    file_manager.reset();
-    if (ordered_channel->isOpen()) {
-        json message = {
-            {"type", "disconnect"},
-        };
-        ordered_channel->send(message.dump());
-    }
-    conn->close();
-    connected = false;
-
-    overlay = nullptr;
-    if (video_pipeline) {
-        gst_element_set_state(video_pipeline.get(), GST_STATE_NULL);
-        video_pipeline.reset();
-    }
-    if (audio_pipeline) {
-        gst_element_set_state(audio_pipeline.get(), GST_STATE_NULL);
-        audio_pipeline.reset();
     }
-    playing = false;
 
-    Fl_Double_Window::hide();
+    install_video_pipeline(std::move(video));
+    install_audio_pipeline(std::move(audio));
+    playing = true;
 }
 
 void VideoWindow::draw() {
@@ -641,12 +1847,77 @@ unsigned int VideoWindow::get_bitrate() const {
 
 void VideoWindow::set_bitrate(unsigned int bitrate) {
     video_track->requestBitrate((conn_info.bitrate = bitrate) * 1000);
+    bitrate_controller.reset(bitrate);
 }
 
 void VideoWindow::request_keyframe() {
     video_track->requestKeyframe();
 }
 
+void VideoWindow::apply_latency_profile() {
+    LatencyProfileSettings settings = get_latency_profile_settings(conn_info.latency_profile);
+    if (video_jitterbuffer) {
+        // The jitter buffer posts a latency message when its latency changes, which makes the pipeline recalculate its own
+        g_object_set(video_jitterbuffer, "latency", settings.jitterbuffer_latency, nullptr);
+        gst_util_set_object_arg(G_OBJECT(video_jitterbuffer), "mode", settings.jitterbuffer_mode);
+    }
+    if (video_queue) {
+        g_object_set(video_queue, "max-size-time", settings.max_queue_time, nullptr);
+    }
+    if (video_sink) {
+        g_object_set(video_sink, "sync", settings.sync, "max-lateness", settings.max_lateness, nullptr);
+    }
+    if (audio_jitterbuffer) {
+        audio_jitterbuffer_latency = settings.audio_jitterbuffer_latency;
+        audio_jitterbuffer_margin = 0;
+        g_object_set(audio_jitterbuffer, "latency", audio_jitterbuffer_latency, nullptr);
+    }
+}
+
+void VideoWindow::adapt_audio_jitterbuffer() {
+    GstStructure* jitterbuffer_stats = nullptr;
+    g_object_get(audio_jitterbuffer, "stats", &jitterbuffer_stats, nullptr);
+    if (!jitterbuffer_stats) return;
+
+    guint64 jitter = 0;
+    guint64 late = 0;
+    gst_structure_get_uint64(jitterbuffer_stats, "avg-jitter", &jitter);
+    gst_structure_get_uint64(jitterbuffer_stats, "num-late", &late);
+    gst_structure_free(jitterbuffer_stats);
+
+    // Three times the mean jitter covers nearly every arrival, and packets that still came too late add a margin that decays slowly
+    if (late > audio_late_packets) {
+        audio_jitterbuffer_margin = std::min(audio_jitterbuffer_margin + 10, MAX_AUDIO_JITTERBUFFER_LATENCY);
+    } else if (audio_jitterbuffer_margin) {
+        audio_jitterbuffer_margin--;
+    }
+    audio_late_packets = late;
+
+    unsigned int minimum = get_latency_profile_settings(conn_info.latency_profile).audio_jitterbuffer_latency;
+    unsigned int target = std::min(minimum + (unsigned int) std::ceil(jitter * 3. / GST_MSECOND) + audio_jitterbuffer_margin, MAX_AUDIO_JITTERBUFFER_LATENCY);
+
+    // Every change is heard as a small gap or overlap, so the latency grows immediately but only shrinks by a noticeable amount
+    if (target > audio_jitterbuffer_latency || target + 10 < audio_jitterbuffer_latency) {
+        g_object_set(audio_jitterbuffer, "latency", audio_jitterbuffer_latency = target, nullptr);
+    }
+}
+
+LatencyProfile VideoWindow::get_latency_profile() const {
+    return conn_info.latency_profile;
+}
+
+void VideoWindow::set_latency_profile(LatencyProfile latency_profile) {
+    conn_info.latency_profile = latency_profile;
+    apply_latency_profile();
+}
+
+void VideoWindow::handle_video_queue_overrun() {
+    video_queue_overruns++;
+
+    // The queue overruns on every packet while the decoder is stalled, but the requester only lets the first one through
+    keyframe_requester->request();
+}
+
 void VideoWindow::release_all_keys() {
     if (!conn_info.view_only) {
         json message = {
@@ -655,3 +1926,146 @@ void VideoWindow::release_all_keys() {
         ordered_channel->send(message.dump());
     }
 }
+
+IngestStats VideoWindow::get_video_ingest_stats() {
+    return video_ingest ? video_ingest->stats() : IngestStats {};
+}
+
+IngestStats VideoWindow::get_audio_ingest_stats() {
+    return audio_ingest ? audio_ingest->stats() : IngestStats {};
+}
+
+LatencyStats VideoWindow::get_latency_stats() const {
+    return video_latency_tracker ? video_latency_tracker->stats() : LatencyStats {};
+}
+
+HealthStats VideoWindow::get_health_stats() const {
+    return health_monitor->get_stats();
+}
+
+SyncStats VideoWindow::get_sync_stats() const {
+    return av_sync->stats();
+}
+
+SignalingTiming VideoWindow::get_offer_timing() const {
+    return offer_timing;
+}
+
+double VideoWindow::get_startup_time(StartupPhase phase) const {
+    return startup_timer->get(phase);
+}
+
+LatencyStats VideoWindow::get_audio_latency_stats() const {
+    return audio_latency_tracker ? audio_latency_tracker->stats() : LatencyStats {};
+}
+
+NackStats VideoWindow::get_nack_stats() const {
+    return video_nack_requester ? video_nack_requester->get_stats() : NackStats {};
+}
+
+TwccStats VideoWindow::get_twcc_stats() const {
+    return video_twcc_generator ? video_twcc_generator->get_stats() : TwccStats {};
+}
+
+BusStats VideoWindow::get_video_bus_stats() const {
+    return video_bus_monitor ? video_bus_monitor->get_stats() : BusStats {};
+}
+
+BusStats VideoWindow::get_audio_bus_stats() const {
+    return audio_bus_monitor ? audio_bus_monitor->get_stats() : BusStats {};
+}
+
+VideoStatistics VideoWindow::get_statistics() {
+    VideoStatistics ret;
+
+    IngestStats ingest_stats = get_video_ingest_stats();
+    ret.received_fps = ingest_stats.frames_per_second;
+    ret.decoded_fps = decoded_frames.rate();
+    ret.decode_time = get_latency_stats().decode.p50;
+    ret.bitrate = ingest_stats.bytes_per_second * 8. / 1000.;
+    ret.requested_bitrate = conn_info.bitrate;
+    ret.zero_copy = zero_copy_state;
+    ret.overlay_composition = overlay_composition_state;
+    ret.queue_overruns = video_queue_overruns;
+    ret.pool_hits = ingest_stats.pool_hits;
+    ret.pool_misses = ingest_stats.pool_misses;
+    ret.pool_high_water = ingest_stats.pool_high_water;
+
+    if (video_fec_decoder) {
+        guint recovered = 0;
+        guint unrecovered = 0;
+        g_object_get(video_fec_decoder, "recovered", &recovered, "unrecovered", &unrecovered, nullptr);
+        ret.fec_recovered = recovered;
+        ret.fec_unrecovered = unrecovered;
+    }
+
+    NackStats nack_stats = get_nack_stats();
+    ret.nacks_sent = nack_stats.nacks_sent;
+    ret.packets_recovered = nack_stats.packets_recovered;
+    ret.keyframe_requests = keyframe_requester->get_stats().requests_sent;
+
+    TwccStats twcc_stats = get_twcc_stats();
+    ret.twcc_feedback_sent = twcc_stats.feedback_sent;
+    ret.twcc_packets_reported = twcc_stats.packets_reported;
+
+    if (video_sink) {
+        GstStructure* sink_stats = nullptr;
+        g_object_get(video_sink, "stats", &sink_stats, nullptr);
+        if (sink_stats) {
+            gst_structure_get_uint64(sink_stats, "dropped", &ret.dropped_frames);
+            gst_structure_free(sink_stats);
+        }
+    }
+
+    if (video_jitterbuffer) {
+        GstStructure* jitterbuffer_stats = nullptr;
+        g_object_get(video_jitterbuffer, "stats", &jitterbuffer_stats, nullptr);
+        if (jitterbuffer_stats) {
+            guint64 jitter = 0;
+            gst_structure_get_uint64(jitterbuffer_stats, "num-pushed", &ret.packets_received);
+            gst_structure_get_uint64(jitterbuffer_stats, "num-lost", &ret.packets_lost);
+            gst_structure_get_uint64(jitterbuffer_stats, "avg-jitter", &jitter);
+            gst_structure_free(jitterbuffer_stats);
+
+            if (ret.packets_received + ret.packets_lost) {
+                ret.loss_rate = (double) ret.packets_lost / (ret.packets_received + ret.packets_lost);
+            }
+            ret.jitter = jitter / (double) GST_MSECOND;
+        }
+    }
+
+    ret.audio_latency = get_audio_latency_stats().total.p50;
+    ret.audio_jitterbuffer_latency = audio_jitterbuffer_latency;
+
+    if (auto rtt = conn->rtt(); rtt.has_value()) {
+        ret.rtt = rtt->count();
+    }
+
+    return ret;
+}
+
+void VideoWindow::show_statistics(const char* text) {
+    // Drawn on the video itself, since a window of its own would take focus and the pointer away from the stream
+    if (statistics_overlay) {
+        g_object_set(statistics_overlay, "silent", FALSE, "text", text, nullptr);
+    }
+}
+
+bool VideoWindow::is_statistics_visible() const {
+    return statistics_visible;
+}
+
+void VideoWindow::toggle_statistics() {
+    statistics_visible = !statistics_visible;
+    if (!statistics_visible) {
+        if (statistics_overlay) {
+            g_object_set(statistics_overlay, "silent", TRUE, nullptr);
+        }
+    }
+    if (statistics_visible) {
+        Fl::remove_timeout(statistics_timer_callback, this);
+        statistics_timer_callback(this);
+    } else {
+        Fl::remove_timeout(statistics_timer_callback, this);
+    }
+}
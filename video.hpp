@@ -1,19 +1,35 @@
 #pragma once
 
+#include "bitrate.hpp"
+#include "bus.hpp"
 #include "connection.hpp"
 #include "file_manager.hpp"
 #include "glib.hpp"
+#include "health.hpp"
+#include "ingest.hpp"
 #include "input.hpp"
+#include "latency.hpp"
+#include "rtcp.hpp"
+#include "signaling.hpp"
+#include "stats.hpp"
+#include "sync.hpp"
 #include "util.hpp"
 #include <FL/Fl.H>
 #include <FL/Fl_Double_Window.H>
 #include <assert.h>
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <gst/gst.h>
 #include <gst/video/videooverlay.h>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <rtc/rtc.hpp>
+#include <stdint.h>
+#include <string>
+#include <thread>
 
 struct VideoInfo {
     std::mutex mutex;
@@ -21,41 +37,230 @@ struct VideoInfo {
     int height;
 };
 
+enum class ZeroCopyState {
+    Off,
+    SinkPool,       // The decoder writes into buffers from a pool proposed by the sink
+    NegotiatedPool, // The sink didn't propose a pool, so one was added to the allocation query for it
+};
+
+enum class OverlayCompositionState {
+    Unknown,     // The overlay hasn't negotiated allocation with the sink yet
+    Supported,   // The sink renders the overlay from meta, so frames are never modified
+    Unsupported, // The overlay blends into frames, which are read-only and are copied while it is shown
+};
+
+// Milestones on the way to the first frame, which is what a connection's startup time is judged by
+enum class StartupPhase {
+    PluginsLoaded,    // Every element the pipelines may need has had its plugin loaded in the background
+    IceGathered,      // Gathering has completed and the offer is ready to be sent, which is never marked with trickle ICE since the offer doesn't wait
+    AnswerReceived,   // The server has answered the offer
+    PipelineStarted,  // The video pipeline has been set to PLAYING
+    TrackOpen,        // The video track is open and a keyframe has been requested
+    FirstFrame,       // The first video frame has been decoded
+    Count,
+};
+
+struct VideoStatistics {
+    double received_fps = 0.;
+    double decoded_fps = 0.;
+    double decode_time = 0.; // Median, in milliseconds
+    uint64_t dropped_frames = 0;
+    uint64_t packets_received = 0;
+    double bitrate = 0.; // Measured, in kbps
+    unsigned int requested_bitrate = 0;
+    double jitter = 0.; // In milliseconds
+    uint64_t packets_lost = 0;
+    double loss_rate = 0.;
+    double rtt = -1.; // In milliseconds, negative if unknown
+    uint64_t queue_overruns = 0;
+    uint64_t pool_hits = 0;
+    uint64_t pool_misses = 0;
+    unsigned int pool_high_water = 0;
+    uint64_t nacks_sent = 0;
+    uint64_t packets_recovered = 0;
+    uint64_t fec_recovered = 0;
+    uint64_t fec_unrecovered = 0;
+    uint64_t keyframe_requests = 0; // Sent automatically
+    uint64_t twcc_feedback_sent = 0;
+    uint64_t twcc_packets_reported = 0;
+    double audio_latency = 0.; // Median end to end, in milliseconds
+    unsigned int audio_jitterbuffer_latency = 0;
+    ZeroCopyState zero_copy = ZeroCopyState::Off;
+    OverlayCompositionState overlay_composition = OverlayCompositionState::Unknown;
+};
+
+constexpr double PREPARED_CONNECTION_TTL = 20.; // In seconds
+
+// A peer connection with its tracks and channels, which starts gathering ICE candidates as soon as it is created
+// It can be created speculatively before the user connects, and handed to a VideoWindow while its settings still apply
+class PreparedConnection {
+public:
+    ConnectionInfo conn_info;
+    std::chrono::steady_clock::time_point creation_time = std::chrono::steady_clock::now();
+    std::shared_ptr<rtc::PeerConnection> conn;
+    std::shared_ptr<rtc::Track> video_track;
+    std::shared_ptr<rtc::Track> audio_track;
+    std::shared_ptr<rtc::DataChannel> ordered_channel;
+    std::shared_ptr<rtc::DataChannel> unordered_channel;
+    std::shared_ptr<rtc::DataChannel> health_channel;
+    std::map<uint8_t, uint8_t> rtx_payload_types; // Maps each offered RTX payload type to the one it retransmits
+
+    PreparedConnection(ConnectionInfo conn_info);
+    PreparedConnection(const PreparedConnection&) = delete;
+    PreparedConnection(PreparedConnection&&) = delete;
+
+    PreparedConnection& operator=(const PreparedConnection&) = delete;
+    PreparedConnection& operator=(PreparedConnection&&) = delete;
+
+    // A connection that was never taken over is closed
+    ~PreparedConnection() {
+        if (conn) conn->close();
+    }
+
+    // Connects to the server in the background, so that the offer can be sent without waiting for DNS, TCP or TLS
+    void warm_up_signaling() const;
+
+    // The connection can only be taken over if it was prepared recently with the same settings
+    bool is_reusable(const ConnectionInfo& conn_info) const;
+};
+
 class VideoWindow : public Fl_Double_Window {
 protected:
+    // A pipeline that has been built and brought to READY off the main thread, but not yet taken over by the window
+    // It is stopped on destruction unless it was taken over
+    struct VideoPipeline {
+        VideoCodec codec;
+        glib::Object<GstElement> pipeline;
+        std::shared_ptr<TrackIngest> ingest;
+        std::shared_ptr<LatencyTracker> latency_tracker;
+        GstElement* jitterbuffer = nullptr;
+        GstElement* queue = nullptr;
+        GstElement* fec_decoder = nullptr;
+        GstElement* sink = nullptr;
+        GstElement* statistics_overlay = nullptr;
+
+        ~VideoPipeline();
+    };
+
+    struct AudioPipeline {
+        glib::Object<GstElement> pipeline;
+        std::shared_ptr<TrackIngest> ingest;
+        std::shared_ptr<LatencyTracker> latency_tracker;
+        GstElement* jitterbuffer = nullptr;
+        GstElement* sink = nullptr; // Null unless the sink exposes its sync state
+
+        ~AudioPipeline();
+    };
+
     ConnectionInfo conn_info;
 
     std::shared_ptr<rtc::PeerConnection> conn;
     std::shared_ptr<rtc::Track> video_track;
     std::shared_ptr<rtc::Track> audio_track;
+    std::shared_ptr<NackRequester> video_nack_requester;
+    std::shared_ptr<KeyframeRequester> keyframe_requester;
+    std::shared_ptr<TwccFeedbackGenerator> video_twcc_generator;
+    std::shared_ptr<AvSync> av_sync;
+    std::shared_ptr<PhaseTimer<StartupPhase>> startup_timer;
     std::shared_ptr<rtc::DataChannel> ordered_channel;
     std::shared_ptr<rtc::DataChannel> unordered_channel;
+    std::shared_ptr<rtc::DataChannel> health_channel;
+    std::shared_ptr<HealthMonitor> health_monitor;
+    std::optional<unsigned int> health_subscription;
 
     std::unique_ptr<RawMouseManager> mouse_manager;
     std::unique_ptr<KeyboardGrabManager> keyboard_grab_manager;
 
     VideoInfo video_info;
+    VideoCodec video_codec = VideoCodec::H264;
     glib::Object<GstElement> video_pipeline;
     glib::Object<GstElement> audio_pipeline;
+    glib::Object<GstClock> pipeline_clock;
+    GstClockTime pipeline_base_time = 0;
+    std::thread pipeline_thread; // Builds the pipelines while the connection is being established
+    std::shared_ptr<std::atomic<bool>> pipeline_cancel_token;
+    std::unique_ptr<VideoPipeline> pending_video_pipeline; // Built before the window was shown
+    std::unique_ptr<AudioPipeline> pending_audio_pipeline;
+    std::shared_ptr<TrackIngest> video_ingest;
+    std::shared_ptr<TrackIngest> audio_ingest;
+    std::shared_ptr<LatencyTracker> video_latency_tracker;
+    std::shared_ptr<LatencyTracker> audio_latency_tracker;
+    std::unique_ptr<BusMonitor> video_bus_monitor;
+    std::unique_ptr<BusMonitor> audio_bus_monitor;
     GstVideoOverlay* overlay = nullptr;
+    GstElement* video_jitterbuffer = nullptr;
+    GstElement* video_queue = nullptr;
+    GstElement* video_fec_decoder = nullptr;
+    GstElement* video_sink = nullptr;
+    GstElement* statistics_overlay = nullptr;
+    std::atomic<OverlayCompositionState> overlay_composition_state = OverlayCompositionState::Unknown;
+    GstElement* audio_jitterbuffer = nullptr;
+    unsigned int audio_jitterbuffer_latency = 0; // In milliseconds
+    unsigned int audio_jitterbuffer_margin = 0;  // Added after late packets, in milliseconds
+    uint64_t audio_late_packets = 0;
+    RateCounter decoded_frames;
+    std::atomic<ZeroCopyState> zero_copy_state = ZeroCopyState::Off;          // What the decoder's latest frame came from
+    std::atomic<ZeroCopyState> proposed_zero_copy_state = ZeroCopyState::Off; // What the allocation query settled on
+    std::atomic<GstBufferPool*> zero_copy_pool = nullptr;
+    std::atomic<uint64_t> video_queue_overruns = 0;
+    BitrateController bitrate_controller;
+    VideoStatistics last_bitrate_statistics;
 
     bool connected = false;
     bool playing = false;
     bool connection_error = false;
+    bool statistics_visible = false;
 
     std::shared_ptr<std::atomic<bool>> cancel_token;
     std::shared_ptr<Waiter> gathering_waiter;
+    std::shared_ptr<TrickleIce> trickle_ice;
+    SignalingTiming offer_timing;
+    unsigned int reconnect_attempts = 0; // Since the connection was last established
+    std::string stream_id;               // Sent with every offer, so that the server can tell a reconnection from a new session
 
     std::chrono::steady_clock::time_point loading_start_time;
 
     static void loading_timer_callback(void* data);
+    static void statistics_timer_callback(void* data);
+    static void bitrate_timer_callback(void* data);
+    static void audio_jitterbuffer_timer_callback(void* data);
+    static void sync_timer_callback(void* data);
+    static void stall_timer_callback(void* data);
 
     static int system_event_handler(void* event, void* data);
 
+    // Takes over the connection's tracks and channels and sends its offer
+    void attach_connection(std::unique_ptr<PreparedConnection> prepared_conn);
+    void show_statistics(const char* text);
+    void stop_signaling();
+    void handle_health_change();
+    void end_stream();
+    void use_shared_clock(GstElement* pipeline);
+
+    // Builders don't touch the window's elements or state, so they can run on any thread while the window is alive
+    // They only read members that are set before the builder thread starts and never replaced
+    // They return null and set error if an element is missing
+    std::unique_ptr<VideoPipeline> build_video_pipeline(const ConnectionInfo& conn_info, VideoCodec codec, std::string& error);
+    std::unique_ptr<AudioPipeline> build_audio_pipeline(const ConnectionInfo& conn_info, std::string& error);
+
+    // Must be called on the main thread once the window has been shown, since the sink renders into it
+    void install_video_pipeline(std::unique_ptr<VideoPipeline> pipeline);
+    void install_audio_pipeline(std::unique_ptr<AudioPipeline> pipeline);
+    void start_pending_pipelines();
+    void destroy_video_pipeline();
+    void apply_latency_profile();
+    void adapt_audio_jitterbuffer();
+    void handle_video_queue_overrun();
+
 public:
     std::unique_ptr<FileManager> file_manager;
 
-    VideoWindow(int x, int y, int width, int height, ConnectionInfo conn_info);
+    // Called on the main thread once the stream has ended for good, after any error has been shown
+    // The window may be destroyed from here on, but not from within the callback itself
+    std::function<void()> stream_end_cb;
+
+    // The prepared connection is used instead of a new one if it's still reusable, and is closed otherwise
+    VideoWindow(int x, int y, int width, int height, ConnectionInfo conn_info, std::unique_ptr<PreparedConnection> prepared_conn = nullptr);
 
     ~VideoWindow() {
         hide();
@@ -65,6 +270,11 @@ public:
     bool is_playing() const;
     bool has_connection_error() const;
     rtc::PeerConnection::IceState ice_state() const;
+
+    // Replaces a failed connection with a new one while the pipelines and file transfers carry on
+    // Returns false once too many attempts have failed without the connection being established
+    bool reconnect();
+
     void show() override;
     void hide() override;
     void draw() override;
@@ -74,5 +284,22 @@ public:
     unsigned int get_bitrate() const;
     void set_bitrate(unsigned int bitrate);
     void request_keyframe();
+    LatencyProfile get_latency_profile() const;
+    void set_latency_profile(LatencyProfile latency_profile);
     void release_all_keys();
+    IngestStats get_video_ingest_stats();
+    IngestStats get_audio_ingest_stats();
+    LatencyStats get_latency_stats() const;
+    LatencyStats get_audio_latency_stats() const;
+    SyncStats get_sync_stats() const;
+    HealthStats get_health_stats() const;
+    SignalingTiming get_offer_timing() const;
+    double get_startup_time(StartupPhase phase) const;
+    NackStats get_nack_stats() const;
+    TwccStats get_twcc_stats() const;
+    BusStats get_video_bus_stats() const;
+    BusStats get_audio_bus_stats() const;
+    VideoStatistics get_statistics();
+    bool is_statistics_visible() const;
+    void toggle_statistics();
 };